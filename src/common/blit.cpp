@@ -0,0 +1,212 @@
+#include "blit.h"
+
+#include <algorithm>
+
+#include "simd.h"
+
+namespace sr
+{
+
+namespace
+{
+// Columns or rows covered by a loop from a inclusive to b exclusive, clipped to [0, size)
+std::pair<int32_t, int32_t> ClipSpan(int32_t a, int32_t b, size_t size)
+{
+    int32_t begin = a <= b ? a : b + 1;
+    int32_t end = a <= b ? b : a + 1;
+    begin = std::max(begin, 0);
+    end = std::min(end, (int32_t)(size));
+    return std::make_pair(begin, std::max(begin, end));
+}
+
+template <class T>
+void FillRectImpl(Canvas<T>& canvas, int32_t x1, int32_t y1, int32_t x2, int32_t y2, T value)
+{
+    const auto [left, right] = ClipSpan(x1, x2, canvas.width);
+    const auto [bottom, top] = ClipSpan(y1, y2, canvas.height);
+    if (left == right)
+        return;
+
+    // rows from top to bottom are adjacent in memory
+    for (int32_t y = top - 1; y >= bottom; --y)
+    {
+        T* row = &canvas.At(left, y);
+        if (sizeof(T) == 1 || value == T(0))
+            memset(row, (int)(value), sizeof(T) * (right - left));
+        else
+            std::fill_n(row, right - left, value);
+    }
+}
+
+// The part of src which lands inside of dst
+struct BlitArea
+{
+    size_t src_x, src_y;
+    size_t dst_x, dst_y;
+    size_t width, height;
+};
+
+template <class Src, class Dst>
+bool ClipBlit(const Canvas<Src>& src, const Canvas<Dst>& dst, int32_t x, int32_t y,
+              BlitArea& area)
+{
+    const int64_t left = std::max<int64_t>(0, x);
+    const int64_t bottom = std::max<int64_t>(0, y);
+    const int64_t right = std::min((int64_t)(dst.width), (int64_t)(x) + (int64_t)(src.width));
+    const int64_t top = std::min((int64_t)(dst.height), (int64_t)(y) + (int64_t)(src.height));
+    if (left >= right || bottom >= top)
+        return false;
+
+    area.dst_x = (size_t)(left);
+    area.dst_y = (size_t)(bottom);
+    area.src_x = (size_t)(left - x);
+    area.src_y = (size_t)(bottom - y);
+    area.width = (size_t)(right - left);
+    area.height = (size_t)(top - bottom);
+    return true;
+}
+
+template <class Src, class Dst, class RowFunc>
+void ForEachRow(const Canvas<Src>& src, Canvas<Dst>& dst, int32_t x, int32_t y, RowFunc row_func)
+{
+    BlitArea area;
+    if (!ClipBlit(src, dst, x, y, area))
+        return;
+
+    for (size_t row = 0; row < area.height; ++row)
+    {
+        const Src* src_row = &src.At(area.src_x, area.src_y + row);
+        Dst* dst_row = &dst.At(area.dst_x, area.dst_y + row);
+        row_func(src_row, dst_row, area.width);
+    }
+}
+
+const uint32_t OPAQUE_ALPHA = 0xff000000u;
+
+uint8_t Luma(uint32_t color)
+{
+    const uint32_t b = color & 0xff;
+    const uint32_t g = (color >> 8) & 0xff;
+    const uint32_t r = (color >> 16) & 0xff;
+    return (uint8_t)((77 * r + 150 * g + 29 * b + 128) >> 8);
+}
+
+// Exact rounded division by 255 of values up to 255 * 255
+uint32_t Div255(uint32_t value)
+{
+    value += 128;
+    return (value + (value >> 8)) >> 8;
+}
+
+void BlendRow(const uint32_t* src, uint32_t* dst, size_t width)
+{
+    size_t x = 0;
+
+#ifdef SR_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c255 = _mm_set1_epi16(255);
+    const __m128i c128 = _mm_set1_epi16(128);
+    // the alpha channel of the source is weighted by 255 instead of by itself
+    const __m128i alpha_lanes = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+
+    // two pixels as 16-bit channels, blended with weights of at most 255 so sums fit into 16 bits
+    auto blend_half = [&](__m128i s, __m128i d) {
+        const __m128i alpha =
+            _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)),
+                                _MM_SHUFFLE(3, 3, 3, 3));
+        const __m128i inv_alpha = _mm_sub_epi16(c255, alpha);
+        const __m128i sum = _mm_add_epi16(
+            _mm_add_epi16(_mm_mullo_epi16(s, _mm_or_si128(alpha, alpha_lanes)),
+                          _mm_mullo_epi16(d, inv_alpha)),
+            c128);
+        return _mm_srli_epi16(_mm_add_epi16(sum, _mm_srli_epi16(sum, 8)), 8);
+    };
+
+    for (; x + 4 <= width; x += 4)
+    {
+        const __m128i s = _mm_loadu_si128((const __m128i*)(src + x));
+        const __m128i d = _mm_loadu_si128((const __m128i*)(dst + x));
+        const __m128i lo = blend_half(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero));
+        const __m128i hi = blend_half(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero));
+        _mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(lo, hi));
+    }
+#endif
+
+    for (; x < width; ++x)
+        dst[x] = BlendAlpha(src[x], dst[x]);
+}
+} // namespace
+
+void FillRect(Image& canvas, int32_t x1, int32_t y1, int32_t x2, int32_t y2, Color color)
+{
+    FillRectImpl<uint32_t>(canvas, x1, y1, x2, y2, color);
+}
+
+void FillRect(Canvas<uint8_t>& canvas, int32_t x1, int32_t y1, int32_t x2, int32_t y2,
+              uint8_t value)
+{
+    FillRectImpl<uint8_t>(canvas, x1, y1, x2, y2, value);
+}
+
+void Blit(const Image& src, Image& dst, int32_t x, int32_t y)
+{
+    ForEachRow(src, dst, x, y, [](const uint32_t* s, uint32_t* d, size_t width) {
+        memcpy(d, s, sizeof(uint32_t) * width);
+    });
+}
+
+void Blit(const Canvas<uint8_t>& src, Image& dst, int32_t x, int32_t y)
+{
+    ForEachRow(src, dst, x, y, [](const uint8_t* s, uint32_t* d, size_t width) {
+        for (size_t i = 0; i < width; ++i)
+            d[i] = OPAQUE_ALPHA | (s[i] * 0x010101u);
+    });
+}
+
+void Blit(const Image& src, Canvas<uint8_t>& dst, int32_t x, int32_t y)
+{
+    ForEachRow(src, dst, x, y, [](const uint32_t* s, uint8_t* d, size_t width) {
+        for (size_t i = 0; i < width; ++i)
+            d[i] = Luma(s[i]);
+    });
+}
+
+void BlendBlit(const Image& src, Image& dst, int32_t x, int32_t y)
+{
+    ForEachRow(src, dst, x, y, BlendRow);
+}
+
+Color BlendAlpha(Color src, Color dst)
+{
+    const uint32_t alpha = src.a;
+    const uint32_t inv_alpha = 255 - alpha;
+
+    Color result;
+    result.b = (uint8_t)(Div255(src.b * alpha + dst.b * inv_alpha));
+    result.g = (uint8_t)(Div255(src.g * alpha + dst.g * inv_alpha));
+    result.r = (uint8_t)(Div255(src.r * alpha + dst.r * inv_alpha));
+    result.a = (uint8_t)(Div255(alpha * 255 + dst.a * inv_alpha));
+    return result;
+}
+
+Color BlendAdditive(Color src, Color dst)
+{
+    Color result;
+    result.b = (uint8_t)(std::min<uint32_t>(255, dst.b + Div255(src.b * src.a)));
+    result.g = (uint8_t)(std::min<uint32_t>(255, dst.g + Div255(src.g * src.a)));
+    result.r = (uint8_t)(std::min<uint32_t>(255, dst.r + Div255(src.r * src.a)));
+    result.a = dst.a;
+    return result;
+}
+
+Color BlendMultiply(Color src, Color dst)
+{
+    Color result;
+    result.b = (uint8_t)(Div255(src.b * dst.b));
+    result.g = (uint8_t)(Div255(src.g * dst.g));
+    result.r = (uint8_t)(Div255(src.r * dst.r));
+    result.a = dst.a;
+    return result;
+}
+
+} // namespace sr
@@ -0,0 +1,34 @@
+#ifndef _BLIT_H_
+#define _BLIT_H_
+
+#include "canvas.h"
+
+namespace sr
+{
+
+// Fills the rectangle from (x1, y1) inclusive to (x2, y2) exclusive, in any direction, like the
+// pixel loops it replaces. The rectangle is clipped to the canvas once and filled row by row.
+void FillRect(Image& canvas, int32_t x1, int32_t y1, int32_t x2, int32_t y2, Color color);
+void FillRect(Canvas<uint8_t>& canvas, int32_t x1, int32_t y1, int32_t x2, int32_t y2,
+              uint8_t value);
+
+// Copies src with its pixel (0, 0) placed at (x, y) of dst, clipped to dst. Grayscale pixels become
+// opaque colors and colors become their luma.
+void Blit(const Image& src, Image& dst, int32_t x, int32_t y);
+void Blit(const Canvas<uint8_t>& src, Image& dst, int32_t x, int32_t y);
+void Blit(const Image& src, Canvas<uint8_t>& dst, int32_t x, int32_t y);
+
+// Blends src over dst with the alpha of src pixels (not premultiplied). The resulting alpha is
+// a + (1 - a) * dst alpha, so blending onto an opaque canvas keeps it opaque.
+void BlendBlit(const Image& src, Image& dst, int32_t x, int32_t y);
+
+// Single pixel blending with the alpha of src, as BlendBlit does
+Color BlendAlpha(Color src, Color dst);
+// dst + src * alpha, saturated
+Color BlendAdditive(Color src, Color dst);
+// dst * src, alpha of dst is kept
+Color BlendMultiply(Color src, Color dst);
+
+} // namespace sr
+
+#endif
@@ -0,0 +1,104 @@
+#include "bmp.h"
+
+#include <vector>
+
+#include "trace.h"
+
+namespace sr
+{
+
+namespace
+{
+const size_t BMP_FILE_HEADER_SIZE = 14;
+const size_t BMP_INFO_HEADER_SIZE = 40;
+const size_t BMP_HEADERS_SIZE = BMP_FILE_HEADER_SIZE + BMP_INFO_HEADER_SIZE;
+const uint32_t BMP_PIXELS_PER_METER = 2835;
+
+void WriteU16(uint8_t* ptr, uint32_t value)
+{
+    ptr[0] = (uint8_t)(value);
+    ptr[1] = (uint8_t)(value >> 8);
+}
+
+void WriteU32(uint8_t* ptr, uint32_t value)
+{
+    WriteU16(ptr, value);
+    WriteU16(ptr + 2, value >> 16);
+}
+
+// rows are padded to 4 bytes
+size_t RowSize(size_t width, size_t bytespp)
+{
+    return (width * bytespp + 3) & ~size_t(3);
+}
+
+int WriteHeaders(ByteSink& sink, size_t width, size_t height, size_t bytespp)
+{
+    if (width == 0 || height == 0 || width > 0x7fffffff || height > 0x7fffffff)
+        return -1;
+
+    const size_t image_size = RowSize(width, bytespp) * height;
+
+    uint8_t headers[BMP_HEADERS_SIZE] = {'B', 'M'};
+    WriteU32(headers + 2, (uint32_t)(BMP_HEADERS_SIZE + image_size));
+    WriteU32(headers + 10, BMP_HEADERS_SIZE);
+
+    uint8_t* info = headers + BMP_FILE_HEADER_SIZE;
+    WriteU32(info, BMP_INFO_HEADER_SIZE);
+    WriteU32(info + 4, (uint32_t)(width));
+    // negative height means rows from top to bottom, the same as canvas memory
+    WriteU32(info + 8, (uint32_t)(-(int32_t)(height)));
+    WriteU16(info + 12, 1);
+    WriteU16(info + 14, (uint32_t)(bytespp * 8));
+    WriteU32(info + 20, (uint32_t)(image_size));
+    WriteU32(info + 24, BMP_PIXELS_PER_METER);
+    WriteU32(info + 28, BMP_PIXELS_PER_METER);
+
+    return sink.Write(headers, sizeof(headers));
+}
+} // namespace
+
+size_t BmpSize(const Image& canvas)
+{
+    return BMP_HEADERS_SIZE + RowSize(canvas.width, 4) * canvas.height;
+}
+
+size_t BmpSize(const Canvas<uint8_t>& canvas)
+{
+    return BMP_HEADERS_SIZE + RowSize(canvas.width, 3) * canvas.height;
+}
+
+int WriteBmp(ByteSink& sink, const Image& canvas)
+{
+    TRACE_SCOPE("WriteBmp");
+
+    if (WriteHeaders(sink, canvas.width, canvas.height, 4) != 0)
+        return -1;
+
+    // BGRA rows need no padding, so the whole canvas goes out in one write
+    return sink.Write(canvas.Data(), canvas.width * canvas.height * sizeof(uint32_t));
+}
+
+int WriteBmp(ByteSink& sink, const Canvas<uint8_t>& canvas)
+{
+    TRACE_SCOPE("WriteBmp");
+
+    if (WriteHeaders(sink, canvas.width, canvas.height, 3) != 0)
+        return -1;
+
+    std::vector<uint8_t> row(RowSize(canvas.width, 3), 0);
+    for (size_t y = 0; y < canvas.height; ++y)
+    {
+        // staying in RGB-like format even if we have grayscale image
+        const uint8_t* src = canvas.Data() + y * canvas.width;
+        for (size_t x = 0; x < canvas.width; ++x)
+            row[3 * x] = row[3 * x + 1] = row[3 * x + 2] = src[x];
+
+        if (sink.Write(row.data(), row.size()) != 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+} // namespace sr
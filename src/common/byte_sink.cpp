@@ -0,0 +1,108 @@
+#include "byte_sink.h"
+
+#include <string.h>
+
+namespace sr
+{
+
+FileSink::FileSink(size_t buffer_size)
+    : file_(nullptr), owns_file_(false), buffer_(buffer_size), used_(0)
+{}
+
+FileSink::FileSink(FILE* file, size_t buffer_size)
+    : file_(file), owns_file_(false), buffer_(buffer_size), used_(0)
+{}
+
+FileSink::~FileSink()
+{
+    if (owns_file_)
+        Close();
+    else
+        Flush();
+}
+
+int FileSink::Open(const char* path)
+{
+    Close();
+
+    file_ = fopen(path, "wb");
+    if (file_ == nullptr)
+        return -1;
+
+    // everything is buffered here already
+    setvbuf(file_, nullptr, _IONBF, 0);
+    owns_file_ = true;
+    return 0;
+}
+
+int FileSink::Open(FILE* file)
+{
+    Close();
+
+    file_ = file;
+    owns_file_ = false;
+    return file_ != nullptr ? 0 : -1;
+}
+
+int FileSink::Close()
+{
+    if (file_ == nullptr)
+        return 0;
+
+    int status = Drain();
+    if (owns_file_ && fclose(file_) != 0)
+        status = -1;
+
+    file_ = nullptr;
+    owns_file_ = false;
+    return status;
+}
+
+int FileSink::Write(const void* data, size_t size)
+{
+    if (file_ == nullptr)
+        return -1;
+
+    if (used_ + size > buffer_.size())
+    {
+        if (Drain() != 0)
+            return -1;
+        if (size >= buffer_.size())
+            return fwrite(data, 1, size, file_) == size ? 0 : -1;
+    }
+
+    memcpy(buffer_.data() + used_, data, size);
+    used_ += size;
+    return 0;
+}
+
+int FileSink::Flush()
+{
+    if (file_ == nullptr)
+        return -1;
+
+    if (Drain() != 0)
+        return -1;
+    return fflush(file_) == 0 ? 0 : -1;
+}
+
+int FileSink::Drain()
+{
+    const size_t size = used_;
+    used_ = 0;
+    if (size == 0)
+        return 0;
+    return fwrite(buffer_.data(), 1, size, file_) == size ? 0 : -1;
+}
+
+int MemorySink::Write(const void* data, size_t size)
+{
+    if (size > capacity_ - size_)
+        return -1;
+
+    memcpy(data_ + size_, data, size);
+    size_ += size;
+    return 0;
+}
+
+} // namespace sr
@@ -0,0 +1,89 @@
+#ifndef _BYTE_SINK_H_
+#define _BYTE_SINK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+namespace sr
+{
+
+// Destination of encoded frames. Write and Flush return 0 on success and -1 on error.
+class ByteSink
+{
+  public:
+    virtual ~ByteSink() = default;
+
+    virtual int Write(const void* data, size_t size) = 0;
+
+    virtual int Flush()
+    {
+        return 0;
+    }
+};
+
+// Collects small writes in a large buffer, writes that do not fit into it go to the file directly
+class FileSink : public ByteSink
+{
+  public:
+    static const size_t DEFAULT_BUFFER_SIZE = 1 << 20;
+
+    explicit FileSink(size_t buffer_size = DEFAULT_BUFFER_SIZE);
+    // the sink does not close streams it has not opened, e.g. stdout
+    explicit FileSink(FILE* file, size_t buffer_size = DEFAULT_BUFFER_SIZE);
+    ~FileSink() override;
+
+    FileSink(const FileSink&) = delete;
+    FileSink& operator=(const FileSink&) = delete;
+
+    int Open(const char* path);
+    int Open(FILE* file);
+    int Close();
+
+    bool IsOpen() const
+    {
+        return file_ != nullptr;
+    }
+
+    int Write(const void* data, size_t size) override;
+    int Flush() override;
+
+  private:
+    int Drain();
+
+    FILE* file_;
+    bool owns_file_;
+    std::vector<uint8_t> buffer_;
+    size_t used_;
+};
+
+// Writes into memory supplied by the caller, fails when it runs out
+class MemorySink : public ByteSink
+{
+  public:
+    MemorySink(void* data, size_t capacity)
+        : data_(static_cast<uint8_t*>(data)), capacity_(capacity), size_(0)
+    {}
+
+    int Write(const void* data, size_t size) override;
+
+    size_t Size() const
+    {
+        return size_;
+    }
+
+    void Reset()
+    {
+        size_ = 0;
+    }
+
+  private:
+    uint8_t* data_;
+    size_t capacity_;
+    size_t size_;
+};
+
+} // namespace sr
+
+#endif
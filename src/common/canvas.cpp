@@ -1,56 +1,361 @@
 #include "canvas.h"
 
+#include <algorithm>
+
+#include <vector>
+
+#include "../platform/file.h"
+#include "byte_sink.h"
+#include "simd.h"
+#include "trace.h"
+
 namespace sr
 {
 
-int LoadTGA(const char* path, Image& result)
+namespace
+{
+enum TgaType
+{
+    TGA_TRUECOLOR = 2,
+    TGA_GRAYSCALE = 3,
+    TGA_RLE_TRUECOLOR = 10,
+    TGA_RLE_GRAYSCALE = 11
+};
+
+const size_t TGA_HEADER_SIZE = 18;
+const uint8_t TGA_RIGHT_TO_LEFT = 0x10;
+const uint8_t TGA_TOP_TO_BOTTOM = 0x20;
+const uint8_t TGA_ALPHA_BITS = 0x08;
+const size_t TGA_MAX_PACKET = 128;
+const uint8_t TGA_FOOTER[26] = {0,   0,   0,   0,   0,   0,   0,   0,   'T', 'R', 'U', 'E', 'V',
+                                'I', 'S', 'I', 'O', 'N', '-', 'X', 'F', 'I', 'L', 'E', '.', 0};
+const uint32_t OPAQUE_ALPHA = 0xff000000;
+
+uint16_t ReadU16(const uint8_t* ptr)
+{
+    return (uint16_t)(ptr[0] | (ptr[1] << 8));
+}
+
+void WriteU16(uint8_t* ptr, size_t value)
+{
+    ptr[0] = (uint8_t)(value);
+    ptr[1] = (uint8_t)(value >> 8);
+}
+
+void ExpandBgr(const uint8_t* src, uint32_t* dst, size_t count)
+{
+    size_t i = 0;
+
+#ifdef SR_SSSE3
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i alpha = _mm_set1_epi32((int)(OPAQUE_ALPHA));
+    // each 16 byte load consumes 12 bytes of 4 pixels, so it must not be the last 6 pixels
+    for (; i + 6 <= count; i += 4)
+    {
+        const __m128i bgr = _mm_loadu_si128((const __m128i*)(src + 3 * i));
+        const __m128i bgra = _mm_or_si128(_mm_shuffle_epi8(bgr, shuffle), alpha);
+        _mm_storeu_si128((__m128i*)(dst + i), bgra);
+    }
+#endif
+
+    // a 32-bit load reads one byte of the next pixel, so the last pixel is assembled bytewise
+    for (; i + 1 < count; ++i)
+    {
+        uint32_t value;
+        memcpy(&value, src + 3 * i, sizeof(value));
+        dst[i] = value | OPAQUE_ALPHA;
+    }
+    for (; i < count; ++i)
+        dst[i] = OPAQUE_ALPHA | src[3 * i] | (src[3 * i + 1] << 8) | (src[3 * i + 2] << 16);
+}
+
+void ConvertPixels(const uint8_t* src, uint32_t* dst, size_t count, size_t bytespp)
 {
-    TGA::Canvas tga;
+    switch (bytespp)
+    {
+    case 4: // BGRA is the layout of Color
+        memcpy(dst, src, count * sizeof(uint32_t));
+        break;
+    case 3:
+        ExpandBgr(src, dst, count);
+        break;
+    case 1:
+        for (size_t i = 0; i < count; ++i)
+            dst[i] = OPAQUE_ALPHA | (src[i] * 0x010101u);
+        break;
+    }
+}
 
-    bool status = tga.read_tga_file(path);
-    if (!status)
+// Maps rows in file order to rows of the image, which are stored from top to bottom
+struct TgaRows
+{
+    uint32_t* data;
+    size_t width;
+    size_t height;
+    bool top_to_bottom;
+
+    uint32_t* Row(size_t file_row) const
+    {
+        return data + (top_to_bottom ? file_row : height - 1 - file_row) * width;
+    }
+};
+
+int DecodeRaw(const uint8_t* src, const uint8_t* end, size_t bytespp, const TgaRows& rows)
+{
+    const size_t row_size = rows.width * bytespp;
+    if ((size_t)(end - src) < row_size * rows.height)
         return -1;
 
-    tga.flip_vertically();
+    for (size_t row = 0; row < rows.height; ++row, src += row_size)
+        ConvertPixels(src, rows.Row(row), rows.width, bytespp);
 
-    const size_t width = (size_t)(tga.get_width());
-    const size_t height = (size_t)(tga.get_height());
+    return 0;
+}
 
-    result.Resize(width, height);
+int DecodeRle(const uint8_t* src, const uint8_t* end, size_t bytespp, const TgaRows& rows)
+{
+    size_t row = 0;
+    size_t x = 0;
 
-    size_t i = 0;
-    for (size_t y = 0; y < height; ++y)
-        for (size_t x = 0; x < width; ++x)
+    while (row < rows.height)
+    {
+        if (src >= end)
+            return -1;
+
+        const uint8_t packet = *src++;
+        const bool is_run = (packet & 0x80) != 0;
+        size_t count = (packet & 0x7f) + 1;
+
+        if ((size_t)(end - src) < (is_run ? 1 : count) * bytespp)
+            return -1;
+
+        uint32_t run_value;
+        if (is_run)
+        {
+            ConvertPixels(src, &run_value, 1, bytespp);
+            src += bytespp;
+        }
+
+        // packets are allowed to continue on the next row
+        while (count > 0 && row < rows.height)
         {
-            TGA::TGAColor tga_color = tga.get(x, y);
+            const size_t n = std::min(count, rows.width - x);
+            if (is_run)
+            {
+                std::fill_n(rows.Row(row) + x, n, run_value);
+            }
+            else
+            {
+                ConvertPixels(src, rows.Row(row) + x, n, bytespp);
+                src += n * bytespp;
+            }
 
-            Color color;
-            color.r = tga_color.bgra[2];
-            color.g = tga_color.bgra[1];
-            color.b = tga_color.bgra[0];
-            result.At(x, y) = color;
+            count -= n;
+            x += n;
+            if (x == rows.width)
+            {
+                x = 0;
+                ++row;
+            }
         }
+    }
 
     return 0;
 }
 
-void DumpTga(const char* path, const Image& image)
+void PackBgr(const uint32_t* src, uint8_t* dst, size_t count)
 {
-    const bool use_rle = false;
+    size_t i = 0;
 
-    TGA::TGAImage tga(image.width, image.height, TGA::TGAImage::RGB);
+#ifdef SR_SSSE3
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    // each 16 byte store fills 12 bytes of 4 pixels, so it must not be the last 6 pixels
+    for (; i + 6 <= count; i += 4)
+    {
+        const __m128i bgra = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(dst + 3 * i), _mm_shuffle_epi8(bgra, shuffle));
+    }
+#endif
 
-    for (size_t y = 0; y < image.height; ++y)
+    // a 32-bit store clobbers one byte of the next pixel, so the last pixel is stored bytewise
+    for (; i + 1 < count; ++i)
+        memcpy(dst + 3 * i, src + i, sizeof(uint32_t));
+    for (; i < count; ++i)
     {
-        for (size_t x = 0; x < image.width; ++x)
+        dst[3 * i] = (uint8_t)(src[i]);
+        dst[3 * i + 1] = (uint8_t)(src[i] >> 8);
+        dst[3 * i + 2] = (uint8_t)(src[i] >> 16);
+    }
+}
+
+uint8_t* PutPixels(const uint32_t* src, size_t count, size_t bytespp, uint8_t* dst)
+{
+    if (bytespp == 4)
+        memcpy(dst, src, count * sizeof(uint32_t));
+    else
+        PackBgr(src, dst, count);
+    return dst + count * bytespp;
+}
+
+size_t TgaMaxRowSize(size_t width, const TgaOptions& options)
+{
+    const size_t bytespp = options.alpha ? 4 : 3;
+    const size_t packets = options.rle ? (width + TGA_MAX_PACKET - 1) / TGA_MAX_PACKET : 0;
+    return width * bytespp + packets;
+}
+
+// Packets never cross rows. Equal pairs start a run, which is never longer than a raw packet.
+size_t EncodeRleRow(const uint32_t* row, size_t width, size_t bytespp, uint8_t* dst)
+{
+    const uint32_t mask = bytespp == 4 ? 0xffffffff : ~OPAQUE_ALPHA;
+    auto equal = [&](size_t i, size_t j) { return ((row[i] ^ row[j]) & mask) == 0; };
+
+    uint8_t* start = dst;
+    size_t x = 0;
+    while (x < width)
+    {
+        size_t count = 1;
+        while (x + count < width && count < TGA_MAX_PACKET && equal(x, x + count))
+            ++count;
+
+        if (count > 1)
+        {
+            *dst++ = (uint8_t)(0x80 | (count - 1));
+            dst = PutPixels(row + x, 1, bytespp, dst);
+            x += count;
+            continue;
+        }
+
+        while (x + count < width && count < TGA_MAX_PACKET &&
+               !(x + count + 1 < width && equal(x + count, x + count + 1)))
+            ++count;
+
+        *dst++ = (uint8_t)(count - 1);
+        dst = PutPixels(row + x, count, bytespp, dst);
+        x += count;
+    }
+
+    return dst - start;
+}
+} // namespace
+
+int LoadTGA(const char* path, Image& result)
+{
+    TRACE_SCOPE("LoadTGA");
+
+    MappedFile file;
+    if (file.Open(path) != 0 || file.Size() < TGA_HEADER_SIZE)
+    {
+        ERROR("LoadTGA could not read file %s\n", path);
+        return -1;
+    }
+
+    const uint8_t* header = file.Data();
+    const uint8_t* end = file.Data() + file.Size();
+
+    const size_t id_length = header[0];
+    const bool has_colormap = header[1] != 0;
+    const uint8_t type = header[2];
+    const size_t colormap_length = ReadU16(header + 5);
+    const size_t colormap_depth = header[7];
+    const size_t width = ReadU16(header + 12);
+    const size_t height = ReadU16(header + 14);
+    const size_t bytespp = header[16] / 8;
+    const uint8_t descriptor = header[17];
+
+    const bool is_supported_type = type == TGA_TRUECOLOR || type == TGA_GRAYSCALE ||
+                                   type == TGA_RLE_TRUECOLOR || type == TGA_RLE_GRAYSCALE;
+    if (!is_supported_type || width == 0 || height == 0 ||
+        (bytespp != 1 && bytespp != 3 && bytespp != 4))
+    {
+        ERROR("LoadTGA: unsupported format of %s (type %d, %d bpp)\n", path, type, header[16]);
+        return -1;
+    }
+
+    const size_t colormap_size = has_colormap ? colormap_length * ((colormap_depth + 7) / 8) : 0;
+    const uint8_t* pixels = header + TGA_HEADER_SIZE + id_length + colormap_size;
+    if (pixels > end)
+        return -1;
+
+    result.Resize(width, height);
+
+    const TgaRows rows = {result.Data(), width, height, (descriptor & TGA_TOP_TO_BOTTOM) != 0};
+    const bool is_rle = type == TGA_RLE_TRUECOLOR || type == TGA_RLE_GRAYSCALE;
+    const int status =
+        is_rle ? DecodeRle(pixels, end, bytespp, rows) : DecodeRaw(pixels, end, bytespp, rows);
+    if (status != 0)
+    {
+        ERROR("LoadTGA: %s is truncated\n", path);
+        return status;
+    }
+
+    if (descriptor & TGA_RIGHT_TO_LEFT)
+    {
+        for (size_t row = 0; row < height; ++row)
+            std::reverse(rows.Row(row), rows.Row(row) + width);
+    }
+
+    return 0;
+}
+
+size_t TgaMaxSize(size_t width, size_t height, const TgaOptions& options)
+{
+    return TGA_HEADER_SIZE + height * TgaMaxRowSize(width, options) + sizeof(TGA_FOOTER);
+}
+
+int WriteTga(ByteSink& sink, const Image& image, const TgaOptions& options)
+{
+    TRACE_SCOPE("WriteTga");
+
+    const size_t width = image.width;
+    const size_t height = image.height;
+    if (width == 0 || height == 0 || width > 0xffff || height > 0xffff)
+        return -1;
+
+    const size_t bytespp = options.alpha ? 4 : 3;
+
+    uint8_t header[TGA_HEADER_SIZE] = {};
+    header[2] = options.rle ? TGA_RLE_TRUECOLOR : TGA_TRUECOLOR;
+    WriteU16(header + 12, width);
+    WriteU16(header + 14, height);
+    header[16] = (uint8_t)(bytespp * 8);
+    // image memory is already top to bottom, so rows go out in memory order
+    header[17] = TGA_TOP_TO_BOTTOM | (options.alpha ? TGA_ALPHA_BITS : 0);
+
+    if (sink.Write(header, sizeof(header)) != 0)
+        return -1;
+
+    if (!options.rle && options.alpha)
+    {
+        if (sink.Write(image.Data(), width * height * sizeof(uint32_t)) != 0)
+            return -1;
+    }
+    else
+    {
+        std::vector<uint8_t> row(TgaMaxRowSize(width, options));
+        for (size_t y = 0; y < height; ++y)
         {
-            const Color color = Color(image.At(x, y));
-            tga.set(x, y, TGA::TGAColor(color.r, color.g, color.b));
+            const uint32_t* pixels = image.Data() + y * width;
+            const size_t size = options.rle ? EncodeRleRow(pixels, width, bytespp, row.data())
+                                            : PutPixels(pixels, width, bytespp, row.data()) -
+                                                  row.data();
+            if (sink.Write(row.data(), size) != 0)
+                return -1;
         }
     }
 
-    tga.flip_vertically();
-    tga.write_tga_file(path, use_rle);
+    return sink.Write(TGA_FOOTER, sizeof(TGA_FOOTER));
+}
+
+int DumpTga(const char* path, const Image& image, const TgaOptions& options)
+{
+    FileSink sink;
+    if (sink.Open(path) != 0 || WriteTga(sink, image, options) != 0 || sink.Close() != 0)
+    {
+        ERROR("DumpTga could not write file %s\n", path);
+        return -1;
+    }
+    return 0;
 }
 
 } // namespace sr
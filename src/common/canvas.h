@@ -1,9 +1,11 @@
 #ifndef _CANVAS_H_
 #define _CANVAS_H_
 
+#include <stddef.h>
+#include <stdint.h>
 #include <string.h>
+#include <utility>
 
-#include "../external/tgaimage/tgaimage.h"
 #include "logging.h"
 
 namespace sr
@@ -46,23 +48,62 @@ template <class T>
 class Canvas
 {
     T* ptr;
+    bool owns_memory;
 
   public:
     size_t width;
     size_t height;
 
-    Canvas() : width(0), height(0), ptr(nullptr)
+    Canvas() : width(0), height(0), ptr(nullptr), owns_memory(true)
     {}
 
-    Canvas(size_t width, size_t height) : width(width), height(height), ptr(new T[width * height])
+    Canvas(size_t width, size_t height)
+        : width(width), height(height), ptr(new T[width * height]), owns_memory(true)
     {}
 
+    // wraps memory owned by somebody else, e.g. a shared memory segment of a window
+    Canvas(T* data, size_t width, size_t height)
+        : width(width), height(height), ptr(data), owns_memory(false)
+    {}
+
+    Canvas(const Canvas&) = delete;
+    Canvas& operator=(const Canvas&) = delete;
+
+    Canvas(Canvas&& other)
+        : ptr(other.ptr), owns_memory(other.owns_memory), width(other.width), height(other.height)
+    {
+        other.ptr = nullptr;
+        other.owns_memory = true;
+        other.width = 0;
+        other.height = 0;
+    }
+
+    Canvas& operator=(Canvas&& other)
+    {
+        std::swap(ptr, other.ptr);
+        std::swap(owns_memory, other.owns_memory);
+        std::swap(width, other.width);
+        std::swap(height, other.height);
+        return *this;
+    }
+
     ~Canvas()
     {
-        if (ptr != nullptr)
+        if (ptr != nullptr && owns_memory)
             delete[] ptr;
     }
 
+    // rows are stored from top to bottom
+    T* Data()
+    {
+        return ptr;
+    }
+
+    const T* Data() const
+    {
+        return ptr;
+    }
+
     T& At(size_t x, size_t y)
     {
         return ptr[x + (height - 1 - y) * width];
@@ -131,20 +172,34 @@ class Canvas
 
     void Resize(size_t width, size_t height)
     {
-        if (ptr != nullptr)
+        if (ptr != nullptr && owns_memory)
             delete[] ptr;
 
         this->width = width;
         this->height = height;
 
         ptr = new T[width * height];
+        owns_memory = true;
     }
 };
 
 typedef Canvas<uint32_t> Image;
 
+class ByteSink;
+
+struct TgaOptions
+{
+    bool rle = false;
+    bool alpha = false; // 32 bpp instead of 24 bpp
+};
+
 int LoadTGA(const char* path, Image& result);
-void DumpTga(const char* path, const Image& image);
+
+// Upper bound of the encoded size, e.g. for sizing a MemorySink
+size_t TgaMaxSize(size_t width, size_t height, const TgaOptions& options = {});
+// Streams rows of the image into the sink without an intermediate copy of the image
+int WriteTga(ByteSink& sink, const Image& image, const TgaOptions& options = {});
+int DumpTga(const char* path, const Image& image, const TgaOptions& options = {});
 
 } // namespace sr
 
@@ -0,0 +1,157 @@
+#include "font.h"
+
+#include <algorithm>
+
+namespace sr
+{
+
+namespace
+{
+const char FIRST_GLYPH = ' ';
+const char LAST_GLYPH = '_';
+const size_t GLYPH_SPACING = 1;
+const size_t LINE_SPACING = 2;
+
+// one byte per column from left to right, bit 0 is the top row
+// clang-format off
+const uint8_t GLYPHS[LAST_GLYPH - FIRST_GLYPH + 1][GLYPH_WIDTH] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00}, // ' '
+    {0x00, 0x00, 0x5f, 0x00, 0x00}, // !
+    {0x00, 0x07, 0x00, 0x07, 0x00}, // "
+    {0x14, 0x7f, 0x14, 0x7f, 0x14}, // #
+    {0x24, 0x2a, 0x7f, 0x2a, 0x12}, // $
+    {0x23, 0x13, 0x08, 0x64, 0x62}, // %
+    {0x36, 0x49, 0x55, 0x22, 0x50}, // &
+    {0x00, 0x05, 0x03, 0x00, 0x00}, // '
+    {0x00, 0x1c, 0x22, 0x41, 0x00}, // (
+    {0x00, 0x41, 0x22, 0x1c, 0x00}, // )
+    {0x08, 0x2a, 0x1c, 0x2a, 0x08}, // *
+    {0x08, 0x08, 0x3e, 0x08, 0x08}, // +
+    {0x00, 0x50, 0x30, 0x00, 0x00}, // ,
+    {0x08, 0x08, 0x08, 0x08, 0x08}, // -
+    {0x00, 0x60, 0x60, 0x00, 0x00}, // .
+    {0x20, 0x10, 0x08, 0x04, 0x02}, // /
+    {0x3e, 0x51, 0x49, 0x45, 0x3e}, // 0
+    {0x00, 0x42, 0x7f, 0x40, 0x00}, // 1
+    {0x42, 0x61, 0x51, 0x49, 0x46}, // 2
+    {0x21, 0x41, 0x45, 0x4b, 0x31}, // 3
+    {0x18, 0x14, 0x12, 0x7f, 0x10}, // 4
+    {0x27, 0x45, 0x45, 0x45, 0x39}, // 5
+    {0x3c, 0x4a, 0x49, 0x49, 0x30}, // 6
+    {0x01, 0x71, 0x09, 0x05, 0x03}, // 7
+    {0x36, 0x49, 0x49, 0x49, 0x36}, // 8
+    {0x06, 0x49, 0x49, 0x29, 0x1e}, // 9
+    {0x00, 0x36, 0x36, 0x00, 0x00}, // :
+    {0x00, 0x56, 0x36, 0x00, 0x00}, // ;
+    {0x08, 0x14, 0x22, 0x41, 0x00}, // <
+    {0x14, 0x14, 0x14, 0x14, 0x14}, // =
+    {0x00, 0x41, 0x22, 0x14, 0x08}, // >
+    {0x02, 0x01, 0x51, 0x09, 0x06}, // ?
+    {0x32, 0x49, 0x79, 0x41, 0x3e}, // @
+    {0x7e, 0x11, 0x11, 0x11, 0x7e}, // A
+    {0x7f, 0x49, 0x49, 0x49, 0x36}, // B
+    {0x3e, 0x41, 0x41, 0x41, 0x22}, // C
+    {0x7f, 0x41, 0x41, 0x22, 0x1c}, // D
+    {0x7f, 0x49, 0x49, 0x49, 0x41}, // E
+    {0x7f, 0x09, 0x09, 0x09, 0x01}, // F
+    {0x3e, 0x41, 0x49, 0x49, 0x7a}, // G
+    {0x7f, 0x08, 0x08, 0x08, 0x7f}, // H
+    {0x00, 0x41, 0x7f, 0x41, 0x00}, // I
+    {0x20, 0x40, 0x41, 0x3f, 0x01}, // J
+    {0x7f, 0x08, 0x14, 0x22, 0x41}, // K
+    {0x7f, 0x40, 0x40, 0x40, 0x40}, // L
+    {0x7f, 0x02, 0x0c, 0x02, 0x7f}, // M
+    {0x7f, 0x04, 0x08, 0x10, 0x7f}, // N
+    {0x3e, 0x41, 0x41, 0x41, 0x3e}, // O
+    {0x7f, 0x09, 0x09, 0x09, 0x06}, // P
+    {0x3e, 0x41, 0x51, 0x21, 0x5e}, // Q
+    {0x7f, 0x09, 0x19, 0x29, 0x46}, // R
+    {0x46, 0x49, 0x49, 0x49, 0x31}, // S
+    {0x01, 0x01, 0x7f, 0x01, 0x01}, // T
+    {0x3f, 0x40, 0x40, 0x40, 0x3f}, // U
+    {0x1f, 0x20, 0x40, 0x20, 0x1f}, // V
+    {0x3f, 0x40, 0x38, 0x40, 0x3f}, // W
+    {0x63, 0x14, 0x08, 0x14, 0x63}, // X
+    {0x07, 0x08, 0x70, 0x08, 0x07}, // Y
+    {0x61, 0x51, 0x49, 0x45, 0x43}, // Z
+    {0x00, 0x7f, 0x41, 0x41, 0x00}, // [
+    {0x02, 0x04, 0x08, 0x10, 0x20}, // '\'
+    {0x00, 0x41, 0x41, 0x7f, 0x00}, // ]
+    {0x04, 0x02, 0x01, 0x02, 0x04}, // ^
+    {0x40, 0x40, 0x40, 0x40, 0x40}, // _
+};
+// clang-format on
+
+const uint8_t* Glyph(char c)
+{
+    if (c >= 'a' && c <= 'z')
+        c = c - 'a' + 'A';
+    if (c < FIRST_GLYPH || c > LAST_GLYPH)
+        c = '?';
+    return GLYPHS[c - FIRST_GLYPH];
+}
+
+void FillRect(Image& image, int32_t x, int32_t y, size_t size, Color color)
+{
+    for (int32_t dy = 0; dy < (int32_t)(size); ++dy)
+    {
+        for (int32_t dx = 0; dx < (int32_t)(size); ++dx)
+            image.SetPixel(x + dx, y - dy, color);
+    }
+}
+} // namespace
+
+size_t TextWidth(const char* text, size_t scale)
+{
+    size_t width = 0;
+    size_t line_length = 0;
+    for (const char* c = text; *c != '\0'; ++c)
+    {
+        line_length = *c == '\n' ? 0 : line_length + 1;
+        width = std::max(width, line_length);
+    }
+
+    if (width == 0)
+        return 0;
+    return scale * (width * (GLYPH_WIDTH + GLYPH_SPACING) - GLYPH_SPACING);
+}
+
+size_t TextHeight(const char* text, size_t scale)
+{
+    if (*text == '\0')
+        return 0;
+
+    const size_t lines = 1 + std::count(text, text + strlen(text), '\n');
+    return scale * (lines * (GLYPH_HEIGHT + LINE_SPACING) - LINE_SPACING);
+}
+
+void DrawText(Image& image, int32_t x, int32_t y, const char* text, Color color, size_t scale)
+{
+    const int32_t advance = (int32_t)(scale * (GLYPH_WIDTH + GLYPH_SPACING));
+    const int32_t line_advance = (int32_t)(scale * (GLYPH_HEIGHT + LINE_SPACING));
+
+    int32_t pen_x = x;
+    for (const char* c = text; *c != '\0'; ++c)
+    {
+        if (*c == '\n')
+        {
+            pen_x = x;
+            y -= line_advance;
+            continue;
+        }
+
+        const uint8_t* glyph = Glyph(*c);
+        for (size_t column = 0; column < GLYPH_WIDTH; ++column)
+        {
+            for (size_t row = 0; row < GLYPH_HEIGHT; ++row)
+            {
+                if (glyph[column] & (1 << row))
+                    FillRect(image, pen_x + (int32_t)(column * scale),
+                             y - (int32_t)(row * scale), scale, color);
+            }
+        }
+        pen_x += advance;
+    }
+}
+
+} // namespace sr
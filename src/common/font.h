@@ -0,0 +1,28 @@
+#ifndef _FONT_H_
+#define _FONT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "canvas.h"
+
+namespace sr
+{
+
+// Built-in 5x7 bitmap font covering printable ASCII up to '_', lowercase letters are drawn as
+// uppercase and anything else as '?'. Glyphs are separated by one pixel, lines by two.
+const size_t GLYPH_WIDTH = 5;
+const size_t GLYPH_HEIGHT = 7;
+
+// size of the text in pixels, lines are separated by '\n'
+size_t TextWidth(const char* text, size_t scale = 1);
+size_t TextHeight(const char* text, size_t scale = 1);
+
+// x, y is the top left corner of the text in canvas coordinates, so lines go to smaller y.
+// Pixels outside of the image are skipped.
+void DrawText(Image& image, int32_t x, int32_t y, const char* text, Color color,
+              size_t scale = 1);
+
+} // namespace sr
+
+#endif
@@ -0,0 +1,50 @@
+#include "frame_scheduler.h"
+
+#include <algorithm>
+
+namespace sr
+{
+
+FrameScheduler::FrameScheduler(uint32_t process_interval_ms, uint32_t target_fps,
+                               uint32_t max_catch_up_steps)
+    : process_interval_(std::chrono::milliseconds(std::max<uint32_t>(process_interval_ms, 1))),
+      frame_interval_(target_fps > 0 ? std::chrono::duration_cast<Clock::duration>(
+                                           std::chrono::seconds(1)) /
+                                           target_fps
+                                     : Clock::duration::zero()),
+      max_catch_up_steps_(std::max<uint32_t>(max_catch_up_steps, 1))
+{
+    Reset(Clock::now());
+}
+
+void FrameScheduler::Reset(Clock::time_point now)
+{
+    next_process_time_ = now;
+    next_frame_time_ = now;
+}
+
+uint32_t FrameScheduler::TakeProcessSteps(Clock::time_point now)
+{
+    if (now < next_process_time_)
+        return 0;
+
+    const uint64_t late = (now - next_process_time_) / process_interval_ + 1;
+    const uint32_t steps = (uint32_t)(std::min<uint64_t>(late, max_catch_up_steps_));
+
+    // dropped steps move the schedule forward as well
+    next_process_time_ += process_interval_ * late;
+    return steps;
+}
+
+bool FrameScheduler::IsFrameDue(Clock::time_point now) const
+{
+    return now >= next_frame_time_;
+}
+
+void FrameScheduler::OnFrame(Clock::time_point now)
+{
+    // a late frame restarts the schedule instead of causing a burst of frames to catch up
+    next_frame_time_ = std::max(next_frame_time_ + frame_interval_, now);
+}
+
+} // namespace sr
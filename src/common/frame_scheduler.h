@@ -0,0 +1,51 @@
+#ifndef _FRAME_SCHEDULER_H_
+#define _FRAME_SCHEDULER_H_
+
+#include <chrono>
+#include <stdint.h>
+
+namespace sr
+{
+
+// Decides when fixed processing steps and frames are due, so that the main loop can sleep until
+// the nearest deadline instead of polling the clock
+class FrameScheduler
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    // target_fps = 0 draws frames as fast as possible
+    FrameScheduler(uint32_t process_interval_ms, uint32_t target_fps, uint32_t max_catch_up_steps);
+
+    // Makes the next step and frame due at now, e.g. after being idle
+    void Reset(Clock::time_point now);
+
+    // Number of processing steps due at now. Steps beyond max_catch_up_steps are dropped, so that
+    // a stall does not turn into a burst of steps.
+    uint32_t TakeProcessSteps(Clock::time_point now);
+
+    bool IsFrameDue(Clock::time_point now) const;
+    void OnFrame(Clock::time_point now);
+
+    Clock::time_point NextProcessTime() const
+    {
+        return next_process_time_;
+    }
+
+    Clock::time_point NextFrameTime() const
+    {
+        return next_frame_time_;
+    }
+
+  private:
+    Clock::duration process_interval_;
+    Clock::duration frame_interval_;
+    uint32_t max_catch_up_steps_;
+
+    Clock::time_point next_process_time_;
+    Clock::time_point next_frame_time_;
+};
+
+} // namespace sr
+
+#endif
@@ -0,0 +1,132 @@
+#include "frame_stats.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+
+#include "font.h"
+
+namespace sr
+{
+
+namespace
+{
+const int32_t OVERLAY_MARGIN = 4;
+const int32_t OVERLAY_PADDING = 3;
+const Color OVERLAY_TEXT_COLOR = Color(0xff, 0xff, 0xff);
+
+float StageMs(const FrameTiming& timing, FrameStage stage)
+{
+    switch (stage)
+    {
+    case FrameStage::PROCESS:
+        return timing.process_ms;
+    case FrameStage::DRAW:
+        return timing.draw_ms;
+    case FrameStage::PRESENT:
+        return timing.present_ms;
+    case FrameStage::FRAME:
+        return timing.frame_ms;
+    }
+    return 0.0f;
+}
+
+float Rank(const std::vector<float>& sorted, float percentile)
+{
+    const size_t rank = (size_t)(ceilf(percentile * sorted.size()));
+    return sorted[std::max<size_t>(rank, 1) - 1];
+}
+
+// halves the brightness, so that the text stays readable over any frame
+void DarkenRect(Image& image, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    x1 = std::max(x1, 0);
+    y1 = std::max(y1, 0);
+    x2 = std::min(x2, (int32_t)(image.width) - 1);
+    y2 = std::min(y2, (int32_t)(image.height) - 1);
+
+    for (int32_t y = y1; y <= y2; ++y)
+    {
+        uint32_t* row = &image.At(0, y);
+        for (int32_t x = x1; x <= x2; ++x)
+            row[x] = (row[x] >> 1) & 0x7f7f7f7f;
+    }
+}
+} // namespace
+
+FrameStats::FrameStats(size_t capacity)
+    : timings_(std::max<size_t>(capacity, 1)), next_(0), count_(0)
+{}
+
+void FrameStats::Add(const FrameTiming& timing)
+{
+    timings_[next_] = timing;
+    next_ = (next_ + 1) % timings_.size();
+    count_ = std::min(count_ + 1, timings_.size());
+}
+
+void FrameStats::Clear()
+{
+    next_ = 0;
+    count_ = 0;
+}
+
+FramePercentiles FrameStats::Percentiles(FrameStage stage) const
+{
+    FramePercentiles result;
+    if (count_ == 0)
+        return result;
+
+    // the oldest frames are overwritten first, so the order in the buffer does not matter
+    sorted_.resize(count_);
+    for (size_t i = 0; i < count_; ++i)
+        sorted_[i] = StageMs(timings_[i], stage);
+    std::sort(sorted_.begin(), sorted_.end());
+
+    result.p50 = Rank(sorted_, 0.50f);
+    result.p95 = Rank(sorted_, 0.95f);
+    result.p99 = Rank(sorted_, 0.99f);
+    result.max = sorted_.back();
+    return result;
+}
+
+std::string FrameStats::Format() const
+{
+    static const struct
+    {
+        const char* name;
+        FrameStage stage;
+    } rows[] = {{"FRAME  ", FrameStage::FRAME},
+                {"PROCESS", FrameStage::PROCESS},
+                {"DRAW   ", FrameStage::DRAW},
+                {"PRESENT", FrameStage::PRESENT}};
+
+    char line[64];
+    snprintf(line, sizeof(line), "MS %4zu   P50   P95   P99   MAX", count_);
+    std::string result = line;
+
+    for (const auto& row : rows)
+    {
+        const FramePercentiles p = Percentiles(row.stage);
+        snprintf(line, sizeof(line), "\n%s %5.1f %5.1f %5.1f %5.1f", row.name, p.p50, p.p95,
+                 p.p99, p.max);
+        result += line;
+    }
+    return result;
+}
+
+void DrawStatsOverlay(Image& image, const FrameStats& stats)
+{
+    const std::string text = stats.Format();
+    const int32_t width = (int32_t)(TextWidth(text.c_str()));
+    const int32_t height = (int32_t)(TextHeight(text.c_str()));
+
+    const int32_t left = OVERLAY_MARGIN;
+    const int32_t top = (int32_t)(image.height) - 1 - OVERLAY_MARGIN;
+    DarkenRect(image, left, top - height - 2 * OVERLAY_PADDING + 1,
+               left + width + 2 * OVERLAY_PADDING - 1, top);
+    DrawText(image, left + OVERLAY_PADDING, top - OVERLAY_PADDING, text.c_str(),
+             OVERLAY_TEXT_COLOR);
+}
+
+} // namespace sr
@@ -0,0 +1,84 @@
+#ifndef _FRAME_STATS_H_
+#define _FRAME_STATS_H_
+
+#include <chrono>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#include "canvas.h"
+
+namespace sr
+{
+
+// Durations in milliseconds of the stages of one frame. Frame is the time since the previous
+// frame was presented, so it includes waiting.
+struct FrameTiming
+{
+    float process_ms = 0.0f;
+    float draw_ms = 0.0f;
+    float present_ms = 0.0f;
+    float frame_ms = 0.0f;
+};
+
+enum class FrameStage
+{
+    PROCESS,
+    DRAW,
+    PRESENT,
+    FRAME
+};
+
+struct FramePercentiles
+{
+    float p50 = 0.0f;
+    float p95 = 0.0f;
+    float p99 = 0.0f;
+    float max = 0.0f;
+};
+
+// Keeps the timings of the last frames in a ring buffer, so that single slow frames show up in
+// the high percentiles instead of disappearing in an average
+class FrameStats
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    static const size_t DEFAULT_CAPACITY = 256;
+
+    explicit FrameStats(size_t capacity = DEFAULT_CAPACITY);
+
+    static float ToMs(Clock::duration duration)
+    {
+        return std::chrono::duration<float, std::milli>(duration).count();
+    }
+
+    void Add(const FrameTiming& timing);
+    void Clear();
+
+    // number of frames in the buffer
+    size_t Count() const
+    {
+        return count_;
+    }
+
+    // Nearest rank percentiles over the frames in the buffer
+    FramePercentiles Percentiles(FrameStage stage) const;
+
+    // table of the percentiles of all stages for the overlay
+    std::string Format() const;
+
+  private:
+    std::vector<FrameTiming> timings_;
+    size_t next_;
+    size_t count_;
+
+    mutable std::vector<float> sorted_;
+};
+
+// Draws the table of the stats into the top left corner of the image over a darkened background
+void DrawStatsOverlay(Image& image, const FrameStats& stats);
+
+} // namespace sr
+
+#endif
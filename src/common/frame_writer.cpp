@@ -0,0 +1,129 @@
+#include "frame_writer.h"
+
+#include <algorithm>
+
+#include "bmp.h"
+#include "byte_sink.h"
+#include "trace.h"
+
+namespace sr
+{
+
+int WriteFrame(const char* path, const Image& frame, FrameFormat format)
+{
+    TRACE_SCOPE("WriteFrame");
+
+    FileSink sink;
+    if (sink.Open(path) != 0)
+    {
+        ERROR("WriteFrame could not open file %s\n", path);
+        return -1;
+    }
+
+    int status;
+    switch (format)
+    {
+    case FrameFormat::BMP:
+        status = WriteBmp(sink, frame);
+        break;
+    case FrameFormat::TGA_RLE:
+        status = WriteTga(sink, frame, TgaOptions{true, false});
+        break;
+    case FrameFormat::TGA:
+    default:
+        status = WriteTga(sink, frame);
+        break;
+    }
+
+    if (sink.Close() != 0 || status != 0)
+    {
+        ERROR("WriteFrame could not write file %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+FrameWriter::FrameWriter(size_t threads, size_t max_queued)
+    : max_queued_(std::max<size_t>(1, max_queued)), writing_(0), failed_(0), stopping_(false)
+{
+    for (size_t i = 0; i < std::max<size_t>(1, threads); ++i)
+        workers_.emplace_back(&FrameWriter::WorkerLoop, this);
+}
+
+FrameWriter::~FrameWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    job_ready_.notify_all();
+
+    // workers drain the queue before they exit
+    for (std::thread& worker : workers_)
+        worker.join();
+}
+
+void FrameWriter::Submit(Image& frame, const std::string& path, FrameFormat format)
+{
+    Image buffer;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        slot_free_.wait(lock, [this]() { return queue_.size() < max_queued_; });
+        if (!free_frames_.empty())
+        {
+            buffer = std::move(free_frames_.back());
+            free_frames_.pop_back();
+        }
+    }
+
+    if (buffer.width != frame.width || buffer.height != frame.height)
+        buffer.Resize(frame.width, frame.height);
+    std::swap(buffer, frame);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(Job{std::move(buffer), path, format});
+    }
+    job_ready_.notify_one();
+}
+
+int FrameWriter::Flush()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this]() { return queue_.empty() && writing_ == 0; });
+
+    const int status = failed_ == 0 ? 0 : -1;
+    failed_ = 0;
+    return status;
+}
+
+void FrameWriter::WorkerLoop()
+{
+    TRACE_THREAD_NAME("frame writer");
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        job_ready_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+        if (queue_.empty())
+            return;
+
+        Job job = std::move(queue_.front());
+        queue_.pop_front();
+        ++writing_;
+        slot_free_.notify_one();
+
+        lock.unlock();
+        const int status = WriteFrame(job.path.c_str(), job.frame, job.format);
+        lock.lock();
+
+        if (status != 0)
+            ++failed_;
+        free_frames_.push_back(std::move(job.frame));
+        --writing_;
+        if (queue_.empty() && writing_ == 0)
+            idle_.notify_all();
+    }
+}
+
+} // namespace sr
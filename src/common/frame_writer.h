@@ -0,0 +1,74 @@
+#ifndef _FRAME_WRITER_H_
+#define _FRAME_WRITER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "canvas.h"
+
+namespace sr
+{
+
+enum class FrameFormat
+{
+    TGA,
+    TGA_RLE,
+    BMP
+};
+
+// Encodes and writes whole frames in a single call
+int WriteFrame(const char* path, const Image& frame, FrameFormat format);
+
+// Background pool of frame encoders. Frames are handed over by swapping buffers with the caller,
+// so submitting never copies pixels.
+class FrameWriter
+{
+  public:
+    explicit FrameWriter(size_t threads = 2, size_t max_queued = 4);
+    // waits for all submitted frames
+    ~FrameWriter();
+
+    FrameWriter(const FrameWriter&) = delete;
+    FrameWriter& operator=(const FrameWriter&) = delete;
+
+    // Takes the pixels of frame and leaves a recycled buffer of the same size with stale content
+    // in its place. Blocks while max_queued frames are waiting for a writer.
+    void Submit(Image& frame, const std::string& path, FrameFormat format = FrameFormat::TGA);
+
+    // Waits until every submitted frame is written. Returns -1 if any of them failed since the
+    // previous flush.
+    int Flush();
+
+  private:
+    struct Job
+    {
+        Image frame;
+        std::string path;
+        FrameFormat format;
+    };
+
+    void WorkerLoop();
+
+    const size_t max_queued_;
+
+    std::mutex mutex_;
+    std::condition_variable job_ready_;
+    std::condition_variable slot_free_;
+    std::condition_variable idle_;
+
+    std::deque<Job> queue_;
+    std::vector<Image> free_frames_;
+    size_t writing_;
+    size_t failed_;
+    bool stopping_;
+
+    std::vector<std::thread> workers_;
+};
+
+} // namespace sr
+
+#endif
@@ -0,0 +1,136 @@
+#include "image_scale.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "simd.h"
+
+namespace sr
+{
+
+namespace
+{
+const int WEIGHT_BITS = 7;
+const int WEIGHT_ONE = 1 << WEIGHT_BITS;
+
+// Source position of each destination pixel along one axis: index of the first of the two source
+// pixels and the weight of the second one. The second pixel always exists, so the first index is
+// at most size - 2 and the weight is 1 at the last pixel.
+struct Tap
+{
+    size_t index;
+    int weight;
+};
+
+std::vector<Tap> ComputeTaps(size_t src_size, size_t dst_size)
+{
+    std::vector<Tap> taps(dst_size);
+    const float ratio = (float)(src_size) / (float)(dst_size);
+
+    for (size_t i = 0; i < dst_size; ++i)
+    {
+        const float position = std::max(0.0f, (i + 0.5f) * ratio - 0.5f);
+        size_t index = (size_t)(position);
+        int weight = (int)((position - index) * WEIGHT_ONE + 0.5f);
+
+        if (src_size < 2)
+        {
+            index = 0;
+            weight = 0;
+        }
+        else if (index >= src_size - 1)
+        {
+            index = src_size - 2;
+            weight = WEIGHT_ONE;
+        }
+
+        taps[i] = {index, weight};
+    }
+    return taps;
+}
+
+int Lerp(int a, int b, int weight)
+{
+    return a + (((b - a) * weight) >> WEIGHT_BITS);
+}
+
+uint32_t LerpPixel(uint32_t a, uint32_t b, int weight)
+{
+    uint32_t result = 0;
+    for (int shift = 0; shift < 32; shift += 8)
+        result |= (uint32_t)(Lerp((a >> shift) & 0xff, (b >> shift) & 0xff, weight)) << shift;
+    return result;
+}
+
+void ScaleRow(const uint32_t* top, const uint32_t* bottom, int y_weight,
+              const std::vector<Tap>& x_taps, size_t src_width, uint32_t* dst)
+{
+    size_t x = 0;
+
+#ifdef SR_SSE2
+    if (src_width >= 2)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i wy = _mm_set1_epi16((short)(y_weight));
+
+        for (; x < x_taps.size(); ++x)
+        {
+            const Tap& tap = x_taps[x];
+
+            // both source pixels of each row as 16-bit channels, left pixel in the low half
+            const __m128i t = _mm_unpacklo_epi8(
+                _mm_loadl_epi64((const __m128i*)(top + tap.index)), zero);
+            const __m128i b = _mm_unpacklo_epi8(
+                _mm_loadl_epi64((const __m128i*)(bottom + tap.index)), zero);
+
+            // differences of at most 255 times weights of at most 128 fit into 16 bits
+            const __m128i vertical =
+                _mm_add_epi16(t, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(b, t), wy),
+                                                WEIGHT_BITS));
+            const __m128i right = _mm_unpackhi_epi64(vertical, vertical);
+            const __m128i wx = _mm_set1_epi16((short)(tap.weight));
+            const __m128i result = _mm_add_epi16(
+                vertical,
+                _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(right, vertical), wx), WEIGHT_BITS));
+
+            dst[x] = (uint32_t)(_mm_cvtsi128_si32(_mm_packus_epi16(result, result)));
+        }
+    }
+#endif
+
+    for (; x < x_taps.size(); ++x)
+    {
+        const Tap& tap = x_taps[x];
+        const size_t next = std::min(tap.index + 1, src_width - 1);
+        const uint32_t left = LerpPixel(top[tap.index], bottom[tap.index], y_weight);
+        const uint32_t right = LerpPixel(top[next], bottom[next], y_weight);
+        dst[x] = LerpPixel(left, right, tap.weight);
+    }
+}
+} // namespace
+
+void ScaleBilinear(const Image& src, Image& dst)
+{
+    if (src.width == 0 || src.height == 0 || dst.width == 0 || dst.height == 0)
+        return;
+
+    if (src.width == dst.width && src.height == dst.height)
+    {
+        src.CopyTo(dst.Data(), dst.width * dst.height);
+        return;
+    }
+
+    const std::vector<Tap> x_taps = ComputeTaps(src.width, dst.width);
+    const std::vector<Tap> y_taps = ComputeTaps(src.height, dst.height);
+
+    // rows of both images are stored from top to bottom, so memory rows map directly
+    for (size_t y = 0; y < dst.height; ++y)
+    {
+        const Tap& tap = y_taps[y];
+        const uint32_t* top = src.Data() + tap.index * src.width;
+        const uint32_t* bottom = src.height > 1 ? top + src.width : top;
+        ScaleRow(top, bottom, tap.weight, x_taps, src.width, dst.Data() + y * dst.width);
+    }
+}
+
+} // namespace sr
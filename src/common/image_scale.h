@@ -0,0 +1,15 @@
+#ifndef _IMAGE_SCALE_H_
+#define _IMAGE_SCALE_H_
+
+#include "canvas.h"
+
+namespace sr
+{
+
+// Resamples src to the size of dst with bilinear filtering. Pixel centers of both images are
+// aligned and weights have 7 bits of precision, an image of the same size is copied unchanged.
+void ScaleBilinear(const Image& src, Image& dst);
+
+} // namespace sr
+
+#endif
@@ -2,6 +2,7 @@
 #define _INPUT_H_
 
 #include <string.h>
+#include <tuple>
 
 #include "key_codes.h"
 
@@ -26,6 +27,20 @@ class Input
     {
         memset(keys_, 0, sizeof(keys_));
         active_ = true;
+        has_events_ = false;
+    }
+
+    // no events since the last processing iteration and nothing is held
+    bool IsIdle() const
+    {
+        if (has_events_)
+            return false;
+        for (bool key : keys_)
+        {
+            if (key)
+                return false;
+        }
+        return true;
     }
 
     bool IsPressed(uint32_t key)
@@ -57,43 +72,51 @@ class Input
 
     void OnKeyDown(uint32_t key)
     {
+        has_events_ = true;
         keys_[key] = true;
     }
 
     void OnKeyUp(uint32_t key)
     {
+        has_events_ = true;
         keys_[key] = false;
     }
 
     void OnFocus()
     {
+        has_events_ = true;
         active_ = true;
     }
 
     void OnFocusLost()
     {
+        has_events_ = true;
         memset(keys_, 0, sizeof(keys_));
         active_ = false;
     }
 
     void OnMouseButtonDown(uint32_t button, int x, int y)
     {
+        has_events_ = true;
         keys_[button] = true;
         click_points_[button] = Point{x, y};
     }
 
     void OnMouseButtonUp(uint32_t button, int /* x */, int /* y */)
     {
+        has_events_ = true;
         keys_[button] = false;
     }
 
     void OnMouseMotion(int x, int y)
     {
+        has_events_ = true;
         mouse_coord_ = Point{x, y};
     }
 
     void OnProcessingIterationEnd()
     {
+        has_events_ = false;
         prev_mouse_coord_ = mouse_coord_;
     }
 
@@ -102,6 +125,7 @@ class Input
 
     bool keys_[256];
     bool active_;
+    bool has_events_;
 
     Point click_points_[MAX_MOUSE_BUTTON_KEYCODE + 1];
     Point mouse_coord_;
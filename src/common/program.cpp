@@ -1,5 +1,12 @@
 #include "program.h"
 
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "image_scale.h"
+#include "trace.h"
+
 namespace sr
 {
 
@@ -10,35 +17,211 @@ Program::Program(InitF init_callback, ProcessF process_callback, DrawF draw_call
 
 int Program::Run(size_t window_width, size_t window_height, const std::string& window_caption)
 {
-    frame_ = std::make_unique<Image>(window_width, window_height);
-    renderer_ = std::make_unique<Renderer>(*frame_);
+    TRACE_THREAD_NAME("main");
+
+    // drawing and presenting the same frame at once would tear
+    const size_t frame_count = is_pipelined ? std::max<size_t>(swap_chain_length, 2)
+                                            : swap_chain_length;
+    swap_chain_ = std::make_unique<SwapChain>(window_width, window_height, frame_count);
     input_ = std::make_unique<Input>();
 
-    const auto get_frame = [this]() -> Image& { return *frame_; };
+    const auto get_frame = [this]() -> Image& { return swap_chain_->Front(); };
     window_ = std::make_unique<Window>(get_frame, *input_);
 
-    int status = window_->Create(window_width, window_height, window_caption);
+    int status =
+        window_->Create(window_width, window_height, window_caption, swap_chain_->Count());
     if (status != 0)
     {
         ERROR("Could not create window_\n");
         return status;
     }
 
+    // frames wrapping window memory are presented without a copy
+    for (size_t i = 0; i < swap_chain_->Count(); ++i)
+    {
+        if (uint32_t* shared_buffer = window_->SharedBuffer(i))
+            swap_chain_->Frame(i) = Image(shared_buffer, window_width, window_height);
+    }
+
+    renderer_ = std::make_unique<Renderer>(swap_chain_->Back());
+
+    if (is_dynamic_resolution_enabled)
+    {
+        resolution_scaler_ = std::make_unique<ResolutionScaler>(min_resolution_scale, 1.0f);
+        resolution_scale_ = resolution_scaler_->Scale();
+        scaled_memory_ = Image(window_width, window_height);
+    }
+
     window_caption_ = window_caption;
 
     init_callback_(*renderer_);
 
-    return MainLoop();
+    status = is_pipelined ? PipelinedMainLoop() : MainLoop();
+    DumpTrace();
+    return status;
+}
+
+int Program::RunHeadless(size_t width, size_t height, size_t frame_count, VideoStream& output)
+{
+    TRACE_THREAD_NAME("main");
+
+    // frames are written synchronously, so there is nothing to overlap with
+    swap_chain_ = std::make_unique<SwapChain>(width, height, 1);
+    renderer_ = std::make_unique<Renderer>(swap_chain_->Back());
+    input_ = std::make_unique<Input>();
+
+    init_callback_(*renderer_);
+
+    using Clock = FrameStats::Clock;
+
+    const uint64_t fps = output.Fps() > 0 ? output.Fps() : 1;
+    uint64_t last_process_time = 0;
+    last_frame_time_ = Clock::now();
+
+    for (uint64_t frame = 0; frame < frame_count; ++frame)
+    {
+        // timings are measured on the real clock, only processing is simulated
+        FrameTiming timing;
+        auto stage_begin = Clock::now();
+
+        const uint64_t now_time = frame * 1000 / fps;
+        while (now_time - last_process_time >= process_interval_ms)
+        {
+            ProcessStep(*renderer_);
+            last_process_time += process_interval_ms;
+        }
+
+        auto stage_end = Clock::now();
+        timing.process_ms = FrameStats::ToMs(stage_end - stage_begin);
+        stage_begin = stage_end;
+
+        Draw(draw_callback_);
+
+        stage_end = Clock::now();
+        timing.draw_ms = FrameStats::ToMs(stage_end - stage_begin);
+        stage_begin = stage_end;
+
+        if (is_stats_overlay_enabled)
+            DrawStatsOverlay(swap_chain_->Back(), stats_);
+
+        int status = renderer_->StreamTargetScreen(output);
+        if (status != 0)
+        {
+            ERROR("Could not write frame %llu\n", (unsigned long long)(frame));
+            return status;
+        }
+
+        timing.present_ms = FrameStats::ToMs(Clock::now() - stage_begin);
+        RecordFrame(timing);
+    }
+
+    const int status = output.Flush();
+    DumpTrace();
+    return status;
+}
+
+void Program::ProcessStep(Renderer& renderer)
+{
+    TRACE_SCOPE("Process");
+
+    process_callback_(renderer, *input_);
+    input_->OnProcessingIterationEnd();
+}
+
+void Program::Draw(const DrawF& draw)
+{
+    TRACE_SCOPE("Draw");
+
+    if (resolution_scaler_)
+    {
+        const float scale = resolution_scale_;
+        const Image& output = swap_chain_->Back();
+        const size_t width = ResolutionScaler::Scaled(output.width, scale);
+        const size_t height = ResolutionScaler::Scaled(output.height, scale);
+        if (scaled_frame_.width != width || scaled_frame_.height != height)
+            scaled_frame_ = Image(scaled_memory_.Data(), width, height);
+        renderer_->SetFrame(scaled_frame_);
+    }
+
+    renderer_->ResetStats();
+    draw(*renderer_);
+
+    if (resolution_scaler_)
+    {
+        TRACE_SCOPE("Upscale");
+        ScaleBilinear(scaled_frame_, swap_chain_->Back());
+    }
+}
+
+void Program::Present()
+{
+    TRACE_SCOPE("Present");
+
+    // the overlay shows the frames before this one, this one is not finished yet
+    if (is_stats_overlay_enabled)
+        DrawStatsOverlay(swap_chain_->Back(), stats_);
+
+    swap_chain_->Swap();
+    // with dynamic resolution the renderer keeps drawing into the scaled frame
+    if (!resolution_scaler_)
+        renderer_->SetFrame(swap_chain_->Back());
+    window_->Redraw();
+}
+
+void Program::DumpTrace() const
+{
+    if (trace_path.empty())
+        return;
+
+#ifdef SR_ENABLE_TRACING
+    if (Tracer::Instance().Dump(trace_path.c_str()) == 0)
+        LOG("Trace written to %s\n", trace_path.c_str());
+#else
+    WARNING("Tracing is disabled in this build, configure with -DSR_ENABLE_TRACING=ON\n");
+#endif
+}
+
+void Program::RecordFrame(FrameTiming timing)
+{
+    const auto now = FrameStats::Clock::now();
+    timing.frame_ms = FrameStats::ToMs(now - last_frame_time_);
+    last_frame_time_ = now;
+    stats_.Add(timing);
+
+    if (resolution_scaler_)
+    {
+        // pipelined stages overlap, so drawing may take the whole frame
+        const float other_ms = is_pipelined ? 0.0f : timing.process_ms + timing.present_ms;
+        resolution_scale_ = resolution_scaler_->Update(timing.draw_ms, target_frame_ms - other_ms);
+    }
+}
+
+void Program::UpdateCaption(uint32_t fps)
+{
+    std::ostringstream oss;
+    oss << window_caption_ << " (FPS: " << fps;
+    if (resolution_scaler_)
+        oss << ", scale: " << (int)(resolution_scale_ * 100.0f + 0.5f) << "%";
+    oss << ")";
+    window_->SetCaption(oss.str());
 }
 
 int Program::MainLoop()
 {
+    using Clock = FrameScheduler::Clock;
+
     is_running_ = true;
 
-    uint32_t sec_begin_time = GetTimeMs();
+    FrameScheduler scheduler(process_interval_ms, target_fps, max_catch_up_steps);
+    auto sec_begin_time = Clock::now();
     uint32_t fps_counter = 0;
+    last_frame_time_ = sec_begin_time;
+
+    // processing since the previous frame
+    float process_ms = 0.0f;
 
-    uint32_t last_process_time = sec_begin_time;
+    // the first frame is drawn before any processing
+    bool updated = true;
 
     while (is_running_)
     {
@@ -49,35 +232,230 @@ int Program::MainLoop()
             break;
         }
 
-        window_->Redraw();
+        Clock::time_point now = Clock::now();
+        const bool is_idle = is_idle_enabled && input_->IsIdle();
+        if (is_idle)
+        {
+            // processing resumes right away with the next event
+            scheduler.Reset(now);
+        }
+        else
+        {
+            for (uint32_t steps = scheduler.TakeProcessSteps(now); steps > 0; --steps)
+            {
+                const auto process_begin = Clock::now();
+                ProcessStep(*renderer_);
+                process_ms += FrameStats::ToMs(Clock::now() - process_begin);
+                updated = true;
+            }
+        }
 
-        bool updated = false;
-        uint32_t now_time = GetTimeMs();
-        while (now_time - last_process_time >= process_interval_ms)
+        const bool wants_frame = updated || !is_fps_sync_enabled;
+        if (wants_frame && scheduler.IsFrameDue(now))
         {
-            process_callback_(*renderer_, *input_);
-            input_->OnProcessingIterationEnd();
-            updated = true;
-            last_process_time += process_interval_ms;
+            FrameTiming timing;
+            timing.process_ms = process_ms;
+            process_ms = 0.0f;
+
+            // waiting for the server to release the back frame counts as presenting
+            auto stage_begin = Clock::now();
+            {
+                TRACE_SCOPE("WaitPresented");
+                window_->WaitPresented(swap_chain_->Back());
+            }
+            auto stage_end = Clock::now();
+            timing.present_ms = FrameStats::ToMs(stage_end - stage_begin);
+            stage_begin = stage_end;
+
+            Draw(draw_callback_);
+
+            stage_end = Clock::now();
+            timing.draw_ms = FrameStats::ToMs(stage_end - stage_begin);
+            stage_begin = stage_end;
+
+            Present();
+            timing.present_ms += FrameStats::ToMs(Clock::now() - stage_begin);
+            RecordFrame(timing);
+
+            scheduler.OnFrame(now);
+            updated = false;
+            fps_counter += 1;
+        }
+
+        now = Clock::now();
+        if (now - sec_begin_time >= std::chrono::seconds(1))
+        {
+            UpdateCaption(fps_counter);
+            fps_counter = 0;
+            sec_begin_time = now;
         }
 
+        // sleep until the nearest deadline, window events wake the loop up earlier
+        Clock::time_point deadline = Clock::time_point::max();
+        if (!is_idle)
+            deadline = scheduler.NextProcessTime();
         if (updated || !is_fps_sync_enabled)
+            deadline = std::min(deadline, scheduler.NextFrameTime());
+
+        if (deadline == Clock::time_point::max())
+            window_->WaitEvents(-1);
+        else if (deadline > now)
+            window_->WaitEvents(
+                std::chrono::duration_cast<std::chrono::microseconds>(deadline - now).count());
+    }
+
+    return 0;
+}
+
+int Program::PipelinedMainLoop()
+{
+    using Clock = std::chrono::steady_clock;
+
+    // never draws, its frame only provides the size
+    process_renderer_ = std::make_unique<Renderer>(swap_chain_->Front());
+    process_renderer_->Matrices = renderer_->Matrices;
+
+    is_running_ = true;
+    is_back_free_ = true;
+    is_frame_drawn_ = false;
+
+    std::thread process_thread(&Program::ProcessStage, this);
+    std::thread draw_thread(&Program::DrawStage, this);
+
+    auto sec_begin_time = Clock::now();
+    uint32_t fps_counter = 0;
+    last_frame_time_ = sec_begin_time;
+
+    while (true)
+    {
+        {
+            // window events feed the input the process stage reads
+            std::lock_guard<std::mutex> input_lock(input_mutex_);
+            window_->MainLoopRoutine();
+        }
+        if (window_->IsClosed())
+            break;
+
+        std::unique_lock<std::mutex> lock(stage_mutex_);
+        // a short wait keeps window events flowing while nothing is drawn
+        if (stage_changed_.wait_for(lock, std::chrono::milliseconds(1),
+                                    [this]() { return is_frame_drawn_; }))
         {
-            draw_callback_(*renderer_);
+            is_frame_drawn_ = false;
+            FrameTiming timing = drawn_timing_;
+            lock.unlock();
+
+            const auto present_begin = Clock::now();
+            Present();
+            {
+                TRACE_SCOPE("WaitPresented");
+                window_->WaitPresented(swap_chain_->Back());
+            }
+            timing.present_ms = FrameStats::ToMs(Clock::now() - present_begin);
+            RecordFrame(timing);
             fps_counter += 1;
+
+            lock.lock();
+            is_back_free_ = true;
+            stage_changed_.notify_all();
         }
+        lock.unlock();
 
-        if (GetTimeMs() - sec_begin_time >= 1000)
+        if (Clock::now() - sec_begin_time >= std::chrono::seconds(1))
         {
-            std::ostringstream oss;
-            oss << window_caption_ << " (FPS: " << fps_counter << ")";
-            window_->SetCaption(oss.str());
+            UpdateCaption(fps_counter);
             fps_counter = 0;
-            sec_begin_time += 1000;
+            sec_begin_time += std::chrono::seconds(1);
         }
     }
 
+    {
+        std::lock_guard<std::mutex> lock(stage_mutex_);
+        is_running_ = false;
+    }
+    stage_changed_.notify_all();
+
+    process_thread.join();
+    draw_thread.join();
     return 0;
 }
 
+void Program::ProcessStage()
+{
+    TRACE_THREAD_NAME("process");
+
+    using Clock = FrameScheduler::Clock;
+
+    // frames are paced by the draw and present stages
+    FrameScheduler scheduler(process_interval_ms, 0, max_catch_up_steps);
+    auto next_step_time = scheduler.NextProcessTime();
+
+    std::unique_lock<std::mutex> lock(stage_mutex_);
+    while (true)
+    {
+        // waiting on the condition variable lets shutdown interrupt the sleep
+        if (stage_changed_.wait_until(lock, next_step_time, [this]() { return !is_running_; }))
+            return;
+        lock.unlock();
+
+        const auto process_begin = Clock::now();
+        for (uint32_t steps = scheduler.TakeProcessSteps(process_begin); steps > 0; --steps)
+        {
+            std::lock_guard<std::mutex> input_lock(input_mutex_);
+            ProcessStep(*process_renderer_);
+        }
+        next_step_time = scheduler.NextProcessTime();
+
+        auto snapshot = std::make_unique<Snapshot>();
+        snapshot->matrices = process_renderer_->Matrices;
+        snapshot->draw = snapshot_callback ? snapshot_callback(*process_renderer_) : draw_callback_;
+        snapshot->process_ms = FrameStats::ToMs(Clock::now() - process_begin);
+
+        lock.lock();
+        // processing of a snapshot replaced before drawing belongs to the next drawn frame
+        if (snapshot_)
+            snapshot->process_ms += snapshot_->process_ms;
+        snapshot_ = std::move(snapshot);
+        stage_changed_.notify_all();
+    }
+}
+
+void Program::DrawStage()
+{
+    TRACE_THREAD_NAME("draw");
+
+    std::unique_ptr<Snapshot> current;
+
+    std::unique_lock<std::mutex> lock(stage_mutex_);
+    while (true)
+    {
+        // without fps sync the last snapshot is drawn again while nothing new arrives
+        stage_changed_.wait(lock, [this, &current]() {
+            return !is_running_ ||
+                   (is_back_free_ && (snapshot_ || (current && !is_fps_sync_enabled)));
+        });
+        if (!is_running_)
+            return;
+
+        FrameTiming timing;
+        if (snapshot_)
+        {
+            current = std::move(snapshot_);
+            timing.process_ms = current->process_ms;
+        }
+        is_back_free_ = false;
+        lock.unlock();
+
+        const auto draw_begin = FrameStats::Clock::now();
+        renderer_->Matrices = current->matrices;
+        Draw(current->draw);
+        timing.draw_ms = FrameStats::ToMs(FrameStats::Clock::now() - draw_begin);
+
+        lock.lock();
+        drawn_timing_ = timing;
+        is_frame_drawn_ = true;
+        stage_changed_.notify_all();
+    }
+}
+
 } // namespace sr
@@ -1,12 +1,19 @@
 #ifndef _PROGRAM_H_
 #define _PROGRAM_H_
 
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <sstream>
 
 #include "../platform/platform.h"
 #include "../renderer/renderer.h"
+#include "frame_scheduler.h"
+#include "frame_stats.h"
+#include "resolution_scaler.h"
 #include "input.h"
+#include "swap_chain.h"
 #include "window.h"
 
 namespace sr
@@ -18,29 +25,107 @@ class Program
     using InitF = std::function<void(Renderer&)>;
     using ProcessF = std::function<void(Renderer&, Input&)>;
     using DrawF = std::function<void(Renderer&)>;
+    using SnapshotF = std::function<DrawF(Renderer&)>;
 
     Program(InitF init_callback, ProcessF process_callback, DrawF draw_callback);
 
     int Run(size_t window_width, size_t window_height, const std::string& window_caption);
+    // Renders frame_count frames without a window into the stream. Processing runs on a simulated
+    // clock advancing by one frame duration of the stream per frame.
+    int RunHeadless(size_t width, size_t height, size_t frame_count, VideoStream& output);
 
+    // draw only after processing
     bool is_fps_sync_enabled = false;
     uint32_t process_interval_ms = 20;
+    // steps of a late process catch-up beyond this are dropped
+    uint32_t max_catch_up_steps = 5;
+    // frames per second at most, 0 for no limit
+    uint32_t target_fps = 0;
+    // Without input nothing is processed or drawn and the loop blocks on window events. For
+    // viewers which change only on input.
+    bool is_idle_enabled = false;
+    // 2 for double buffering, 3 for triple buffering
+    size_t swap_chain_length = 2;
+
+    // Runs processing, drawing and presenting on separate threads. Processing works on its own
+    // renderer whose matrices are handed to the drawing renderer with every snapshot.
+    bool is_pipelined = false;
+    // Pipelined mode only: called after processing, returns a draw callback holding a copy of the
+    // state it reads. Without it draw_callback is used, which then must not read anything the
+    // process callback writes, except for renderer matrices.
+    SnapshotF snapshot_callback;
+
+    // draws the percentiles of the frame timings into the top left corner of every frame
+    bool is_stats_overlay_enabled = false;
+
+    // Timings of the last frames. Updated by the thread calling Run, read it from the callbacks
+    // only when not pipelined.
+    const FrameStats& Stats() const
+    {
+        return stats_;
+    }
+
+    // Draws at a fraction of the window size picked to keep frames within target_frame_ms and
+    // upscales the result into the presented frame. Not used by RunHeadless.
+    bool is_dynamic_resolution_enabled = false;
+    float target_frame_ms = 1000.0f / 30.0f;
+    float min_resolution_scale = 0.5f;
+
+    // Chrome trace of the run is written here when it ends. Needs a build with SR_ENABLE_TRACING.
+    std::string trace_path;
 
   private:
     int MainLoop();
+    void ProcessStep(Renderer& renderer);
+    void Draw(const DrawF& draw);
+    // shows the frame drawn last and moves drawing to the next frame of the swap chain
+    void Present();
+    void RecordFrame(FrameTiming timing);
+    void DumpTrace() const;
+    void UpdateCaption(uint32_t fps);
+
+    struct Snapshot
+    {
+        MatrixStack matrices;
+        DrawF draw;
+        float process_ms;
+    };
+
+    int PipelinedMainLoop();
+    void ProcessStage();
+    void DrawStage();
 
     InitF init_callback_;
     ProcessF process_callback_;
     DrawF draw_callback_;
 
     std::unique_ptr<Window> window_;
-    std::unique_ptr<Image> frame_;
+    std::unique_ptr<SwapChain> swap_chain_;
     std::unique_ptr<Renderer> renderer_;
     std::unique_ptr<Input> input_;
 
     std::string window_caption_;
 
-    bool is_running_;
+    std::atomic<bool> is_running_;
+
+    FrameStats stats_;
+    FrameStats::Clock::time_point last_frame_time_;
+
+    // dynamic resolution, the scaler is updated with the frame stats and the scale read by drawing
+    std::unique_ptr<ResolutionScaler> resolution_scaler_;
+    std::atomic<float> resolution_scale_;
+    Image scaled_memory_; // at the window size
+    Image scaled_frame_;  // wraps scaled_memory_ at the current scale
+
+    // pipelined mode
+    std::unique_ptr<Renderer> process_renderer_;
+    std::mutex input_mutex_;
+    std::mutex stage_mutex_;
+    std::condition_variable stage_changed_;
+    std::unique_ptr<Snapshot> snapshot_; // the latest one, not taken by drawing yet
+    bool is_back_free_;
+    bool is_frame_drawn_;
+    FrameTiming drawn_timing_; // of the frame drawn last, valid with is_frame_drawn_
 };
 
 } // namespace sr
@@ -0,0 +1,78 @@
+#include "resolution_scaler.h"
+
+#include <algorithm>
+#include <math.h>
+
+namespace sr
+{
+
+namespace
+{
+// part of the budget drawing aims at, the rest absorbs noise
+const float HEADROOM = 0.9f;
+// slow frames are taken into account faster than fast ones
+const float RISE_SMOOTHING = 0.5f;
+const float FALL_SMOOTHING = 0.2f;
+// one step up at most per frame, but down to this part of the scale at once
+const float MAX_SHRINK = 0.8f;
+} // namespace
+
+ResolutionScaler::ResolutionScaler(float min_scale, float max_scale)
+    : min_scale_(std::min(min_scale, max_scale)), max_scale_(max_scale)
+{
+    Reset();
+}
+
+void ResolutionScaler::Reset()
+{
+    scale_ = max_scale_;
+    average_ms_ = -1.0f;
+}
+
+size_t ResolutionScaler::Scaled(size_t size, float scale)
+{
+    return std::max<size_t>(1, (size_t)(size * scale + 0.5f));
+}
+
+float ResolutionScaler::Update(float draw_ms, float budget_ms)
+{
+    if (average_ms_ < 0.0f)
+        average_ms_ = draw_ms;
+    else
+    {
+        const float smoothing = draw_ms > average_ms_ ? RISE_SMOOTHING : FALL_SMOOTHING;
+        average_ms_ += (draw_ms - average_ms_) * smoothing;
+    }
+
+    if (budget_ms <= 0.0f)
+    {
+        scale_ = min_scale_;
+        return scale_;
+    }
+
+    // drawing time per pixel stays the same, pixels grow with the square of the scale
+    float target = max_scale_;
+    if (average_ms_ > 0.0f)
+        target = scale_ * sqrtf(HEADROOM * budget_ms / average_ms_);
+
+    target = std::clamp(target, scale_ * MAX_SHRINK, scale_ + SCALE_STEP);
+    target = std::clamp(target, min_scale_, max_scale_);
+
+    // small changes are noise, rounding towards the current scale keeps the resolution steady
+    float steps = (target - scale_) / SCALE_STEP;
+    steps = steps > 0.0f ? floorf(steps) : ceilf(steps);
+    float next = steps == 0.0f ? scale_ : std::clamp(scale_ + steps * SCALE_STEP, min_scale_,
+                                                     max_scale_);
+    // the limits are not multiples of the step
+    if (target == min_scale_ || target == max_scale_)
+        next = target;
+
+    if (next != scale_)
+    {
+        average_ms_ *= (next * next) / (scale_ * scale_);
+        scale_ = next;
+    }
+    return scale_;
+}
+
+} // namespace sr
@@ -0,0 +1,42 @@
+#ifndef _RESOLUTION_SCALER_H_
+#define _RESOLUTION_SCALER_H_
+
+#include <stddef.h>
+
+namespace sr
+{
+
+// Picks the render resolution as a fraction of the output size from recent draw times. Drawing
+// cost is assumed to be proportional to the number of pixels, the estimate is refined with every
+// frame. The scale moves in steps of SCALE_STEP and drops faster than it rises.
+class ResolutionScaler
+{
+  public:
+    static constexpr float SCALE_STEP = 1.0f / 32.0f;
+
+    ResolutionScaler(float min_scale = 0.5f, float max_scale = 1.0f);
+
+    // Feeds the time drawing the last frame at Scale() took and the time it may take at most,
+    // returns the scale of the next frame
+    float Update(float draw_ms, float budget_ms);
+
+    float Scale() const
+    {
+        return scale_;
+    }
+
+    // scaled size of an output dimension, at least 1
+    static size_t Scaled(size_t size, float scale);
+
+    void Reset();
+
+  private:
+    float min_scale_;
+    float max_scale_;
+    float scale_;
+    float average_ms_; // at the current scale, negative before the first frame
+};
+
+} // namespace sr
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef _SIMD_H_
+#define _SIMD_H_
+
+// SSE2 is a part of x86-64, SSSE3 and newer are used only when enabled by compiler flags
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SR_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__SSSE3__)
+#define SR_SSSE3
+#include <tmmintrin.h>
+#endif
+
+#endif
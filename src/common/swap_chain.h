@@ -0,0 +1,58 @@
+#ifndef _SWAP_CHAIN_H_
+#define _SWAP_CHAIN_H_
+
+#include <vector>
+
+#include "canvas.h"
+
+namespace sr
+{
+
+// Ring of equally sized frames. The back frame is drawn while the front one is presented, with
+// three or more frames drawing does not wait for the previous present either.
+class SwapChain
+{
+  public:
+    SwapChain(size_t width, size_t height, size_t count = 2) : back_(0)
+    {
+        count = count > 0 ? count : 1;
+        frames_.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+            frames_.emplace_back(width, height);
+    }
+
+    size_t Count() const
+    {
+        return frames_.size();
+    }
+
+    Image& Frame(size_t index)
+    {
+        return frames_[index];
+    }
+
+    Image& Back()
+    {
+        return frames_[back_];
+    }
+
+    // the most recently swapped frame, with a single frame the same as Back
+    Image& Front()
+    {
+        return frames_[(back_ + frames_.size() - 1) % frames_.size()];
+    }
+
+    // The back frame becomes the front one, the oldest frame becomes the back one
+    void Swap()
+    {
+        back_ = (back_ + 1) % frames_.size();
+    }
+
+  private:
+    std::vector<Image> frames_;
+    size_t back_;
+};
+
+} // namespace sr
+
+#endif
@@ -0,0 +1,156 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+#include "byte_sink.h"
+#include "logging.h"
+
+namespace sr
+{
+
+namespace
+{
+const auto START_TIME = std::chrono::steady_clock::now();
+
+const char JSON_BEGIN[] = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+const char JSON_END[] = "\n]}\n";
+
+// names are literals of the program, but a quote would break the whole file
+std::string Escape(const char* string)
+{
+    std::string result;
+    for (const char* c = string; *c != '\0'; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+            result += '\\';
+        if ((unsigned char)(*c) >= 0x20)
+            result += *c;
+    }
+    return result;
+}
+} // namespace
+
+Tracer& Tracer::Instance()
+{
+    // never destroyed, threads may still record while static objects are destroyed
+    static Tracer* tracer = new Tracer();
+    return *tracer;
+}
+
+uint64_t Tracer::NowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                                START_TIME)
+        .count();
+}
+
+Tracer::ThreadBuffer& Tracer::CurrentThreadBuffer()
+{
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (buffer != nullptr)
+        return *buffer;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto created = std::make_unique<ThreadBuffer>();
+    created->tid = (uint32_t)(buffers_.size() + 1);
+    created->events.resize(BUFFER_CAPACITY);
+    created->count = 0;
+    buffer = created.get();
+    buffers_.push_back(std::move(created));
+    return *buffer;
+}
+
+void Tracer::Record(const char* name, uint64_t begin_ns, uint64_t end_ns)
+{
+    ThreadBuffer& buffer = CurrentThreadBuffer();
+
+    // only this thread writes the count
+    const uint64_t count = buffer.count.load(std::memory_order_relaxed);
+    buffer.events[count % BUFFER_CAPACITY] = {name, begin_ns, end_ns - begin_ns};
+    buffer.count.store(count + 1, std::memory_order_release);
+}
+
+void Tracer::SetThreadName(const char* name)
+{
+    ThreadBuffer& buffer = CurrentThreadBuffer();
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffer.name = name;
+}
+
+int Tracer::WriteJson(ByteSink& sink) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (sink.Write(JSON_BEGIN, sizeof(JSON_BEGIN) - 1) != 0)
+        return -1;
+
+    bool is_first = true;
+    const auto write_line = [&sink, &is_first](const std::string& line) {
+        const char* separator = is_first ? "" : ",\n";
+        is_first = false;
+        if (sink.Write(separator, strlen(separator)) != 0)
+            return -1;
+        return sink.Write(line.data(), line.size());
+    };
+
+    char line[256];
+    for (const auto& buffer : buffers_)
+    {
+        if (!buffer->name.empty())
+        {
+            snprintf(line, sizeof(line),
+                     "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                     "\"args\":{\"name\":\"%s\"}}",
+                     buffer->tid, Escape(buffer->name.c_str()).c_str());
+            if (write_line(line) != 0)
+                return -1;
+        }
+
+        const uint64_t count = buffer->count.load(std::memory_order_acquire);
+        const uint64_t first = count > BUFFER_CAPACITY ? count - BUFFER_CAPACITY : 0;
+        for (uint64_t i = first; i < count; ++i)
+        {
+            const TraceEvent& event = buffer->events[i % BUFFER_CAPACITY];
+            // timestamps are microseconds, fractions keep short events apart
+            snprintf(line, sizeof(line),
+                     "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                     Escape(event.name).c_str(), buffer->tid, event.begin_ns / 1000.0,
+                     event.duration_ns / 1000.0);
+            if (write_line(line) != 0)
+                return -1;
+        }
+    }
+
+    if (sink.Write(JSON_END, sizeof(JSON_END) - 1) != 0)
+        return -1;
+    return sink.Flush();
+}
+
+int Tracer::Dump(const char* path) const
+{
+    FileSink sink;
+    if (sink.Open(path) != 0)
+    {
+        ERROR("Tracer: could not open %s\n", path);
+        return -1;
+    }
+
+    if (WriteJson(sink) != 0)
+    {
+        ERROR("Tracer: could not write %s\n", path);
+        return -1;
+    }
+    return sink.Close();
+}
+
+void Tracer::Clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& buffer : buffers_)
+        buffer->count.store(0, std::memory_order_release);
+}
+
+} // namespace sr
@@ -0,0 +1,102 @@
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace sr
+{
+
+class ByteSink;
+
+// Complete event of the Chrome trace format. The name must be a string literal, only the pointer
+// is stored.
+struct TraceEvent
+{
+    const char* name;
+    uint64_t begin_ns;
+    uint64_t duration_ns;
+};
+
+// Collects trace events of all threads. Each thread records into its own ring buffer without
+// locking, only the first event of a thread takes a lock to register the buffer. The newest
+// events of a thread are kept when its buffer is full.
+class Tracer
+{
+  public:
+    static constexpr size_t BUFFER_CAPACITY = 1 << 16;
+
+    static Tracer& Instance();
+
+    // nanoseconds since the start of the process
+    static uint64_t NowNs();
+
+    void Record(const char* name, uint64_t begin_ns, uint64_t end_ns);
+    // shown instead of the thread id by trace viewers
+    void SetThreadName(const char* name);
+
+    // Writes JSON of the Chrome trace event format, which chrome://tracing and Perfetto load.
+    // Threads should not record meanwhile, events overwritten during the export may be torn.
+    int WriteJson(ByteSink& sink) const;
+    int Dump(const char* path) const;
+
+    // drops the recorded events, the threads keep their buffers and names
+    void Clear();
+
+  private:
+    struct ThreadBuffer
+    {
+        uint32_t tid;
+        std::string name;
+        std::vector<TraceEvent> events;
+        std::atomic<uint64_t> count; // recorded since the last Clear, published with release
+    };
+
+    Tracer() = default;
+
+    ThreadBuffer& CurrentThreadBuffer();
+
+    mutable std::mutex mutex_; // guards the list of buffers and the names
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+};
+
+// records the lifetime of the scope as one event
+class TraceScope
+{
+  public:
+    explicit TraceScope(const char* name) : name_(name), begin_ns_(Tracer::NowNs())
+    {}
+
+    ~TraceScope()
+    {
+        Tracer::Instance().Record(name_, begin_ns_, Tracer::NowNs());
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+  private:
+    const char* name_;
+    uint64_t begin_ns_;
+};
+
+} // namespace sr
+
+// The markers compile to nothing unless SR_ENABLE_TRACING is defined, see the SR_ENABLE_TRACING
+// option of CMakeLists.txt
+#ifdef SR_ENABLE_TRACING
+#define SR_TRACE_CONCAT_IMPL(a, b) a##b
+#define SR_TRACE_CONCAT(a, b) SR_TRACE_CONCAT_IMPL(a, b)
+#define TRACE_SCOPE(name) ::sr::TraceScope SR_TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_THREAD_NAME(name) ::sr::Tracer::Instance().SetThreadName(name)
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+#endif
+
+#endif
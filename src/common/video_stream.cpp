@@ -0,0 +1,272 @@
+#include "video_stream.h"
+
+#include <algorithm>
+#include <string>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include "simd.h"
+#include "trace.h"
+
+namespace sr
+{
+
+namespace
+{
+const char Y4M_FRAME_HEADER[] = "FRAME\n";
+
+uint8_t Luma(int r, int g, int b)
+{
+    return (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+}
+
+uint8_t ChromaU(int r, int g, int b)
+{
+    return (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+}
+
+uint8_t ChromaV(int r, int g, int b)
+{
+    return (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+}
+
+int Red(uint32_t pixel)
+{
+    return (pixel >> 16) & 0xff;
+}
+
+int Green(uint32_t pixel)
+{
+    return (pixel >> 8) & 0xff;
+}
+
+int Blue(uint32_t pixel)
+{
+    return pixel & 0xff;
+}
+
+uint8_t Luma(uint32_t pixel)
+{
+    return Luma(Red(pixel), Green(pixel), Blue(pixel));
+}
+
+#ifdef SR_SSE2
+// 8 pixels to 16-bit b, g, r
+void Deinterleave(const uint32_t* src, __m128i& b, __m128i& g, __m128i& r)
+{
+    const __m128i mask = _mm_set1_epi32(0xff);
+    const __m128i p0 = _mm_loadu_si128((const __m128i*)(src));
+    const __m128i p1 = _mm_loadu_si128((const __m128i*)(src + 4));
+    b = _mm_packs_epi32(_mm_and_si128(p0, mask), _mm_and_si128(p1, mask));
+    g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 8), mask),
+                        _mm_and_si128(_mm_srli_epi32(p1, 8), mask));
+    r = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 16), mask),
+                        _mm_and_si128(_mm_srli_epi32(p1, 16), mask));
+}
+
+// the sum fits into 16 bits only as unsigned, so the shift must be logical
+void StoreLuma(__m128i b, __m128i g, __m128i r, uint8_t* dst)
+{
+    __m128i y = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(66)),
+                              _mm_mullo_epi16(g, _mm_set1_epi16(129)));
+    y = _mm_add_epi16(y, _mm_mullo_epi16(b, _mm_set1_epi16(25)));
+    y = _mm_srli_epi16(_mm_add_epi16(y, _mm_set1_epi16(128)), 8);
+    y = _mm_add_epi16(y, _mm_set1_epi16(16));
+    _mm_storel_epi64((__m128i*)(dst), _mm_packus_epi16(y, y));
+}
+
+// averages 2x2 blocks of two rows of 8 values to 4 values, duplicated into 8 16-bit lanes
+__m128i Average2x2(__m128i top, __m128i bottom)
+{
+    const __m128i sum = _mm_madd_epi16(_mm_add_epi16(top, bottom), _mm_set1_epi16(1));
+    const __m128i average = _mm_srli_epi32(_mm_add_epi32(sum, _mm_set1_epi32(2)), 2);
+    return _mm_packs_epi32(average, average);
+}
+
+// c1 * x1 + c2 * x2 + c3 * x3 for 4 values, rounded and offset like the scalar code
+void StoreChroma(__m128i x1, __m128i x2, __m128i x3, short c1, short c2, short c3, uint8_t* dst)
+{
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i c12 = _mm_setr_epi16(c1, c2, c1, c2, c1, c2, c1, c2);
+    const __m128i c3_round = _mm_setr_epi16(c3, 128, c3, 128, c3, 128, c3, 128);
+    const __m128i pairs = _mm_madd_epi16(_mm_unpacklo_epi16(x1, x2), c12);
+    const __m128i rest = _mm_madd_epi16(_mm_unpacklo_epi16(x3, ones), c3_round);
+    __m128i value = _mm_srai_epi32(_mm_add_epi32(pairs, rest), 8);
+    value = _mm_add_epi32(value, _mm_set1_epi32(128));
+    value = _mm_packs_epi32(value, value);
+    const int packed = _mm_cvtsi128_si32(_mm_packus_epi16(value, value));
+    memcpy(dst, &packed, 4);
+}
+
+void ConvertBlock(const uint32_t* top, const uint32_t* bottom, uint8_t* y_top, uint8_t* y_bottom,
+                  uint8_t* u, uint8_t* v)
+{
+    __m128i b0, g0, r0, b1, g1, r1;
+    Deinterleave(top, b0, g0, r0);
+    Deinterleave(bottom, b1, g1, r1);
+
+    StoreLuma(b0, g0, r0, y_top);
+    StoreLuma(b1, g1, r1, y_bottom);
+
+    const __m128i b = Average2x2(b0, b1);
+    const __m128i g = Average2x2(g0, g1);
+    const __m128i r = Average2x2(r0, r1);
+    StoreChroma(b, g, r, 112, -74, -38, u);
+    StoreChroma(r, g, b, 112, -94, -18, v);
+}
+#endif
+
+void SwapRedBlue(const uint32_t* src, uint8_t* dst, size_t count)
+{
+    size_t i = 0;
+
+#ifdef SR_SSSE3
+    const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    // each 16 byte store fills 12 bytes of 4 pixels, so it must not be the last 6 pixels
+    for (; i + 6 <= count; i += 4)
+    {
+        const __m128i bgra = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(dst + 3 * i), _mm_shuffle_epi8(bgra, shuffle));
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        dst[3 * i] = (uint8_t)(Red(src[i]));
+        dst[3 * i + 1] = (uint8_t)(Green(src[i]));
+        dst[3 * i + 2] = (uint8_t)(Blue(src[i]));
+    }
+}
+} // namespace
+
+void ConvertToYUV420(const uint32_t* pixels, size_t width, size_t height, uint8_t* y_plane,
+                     uint8_t* u_plane, uint8_t* v_plane)
+{
+    const size_t chroma_width = (width + 1) / 2;
+    const size_t chroma_height = (height + 1) / 2;
+
+    for (size_t cy = 0; cy < chroma_height; ++cy)
+    {
+        const size_t y0 = 2 * cy;
+        const size_t y1 = std::min(y0 + 1, height - 1);
+        const uint32_t* top = pixels + y0 * width;
+        const uint32_t* bottom = pixels + y1 * width;
+        uint8_t* y_top = y_plane + y0 * width;
+        uint8_t* y_bottom = y_plane + y1 * width;
+        uint8_t* u = u_plane + cy * chroma_width;
+        uint8_t* v = v_plane + cy * chroma_width;
+
+        size_t x = 0;
+#ifdef SR_SSE2
+        if (y1 != y0)
+        {
+            for (; x + 8 <= width; x += 8)
+                ConvertBlock(top + x, bottom + x, y_top + x, y_bottom + x, u + x / 2, v + x / 2);
+        }
+#endif
+
+        // odd sizes replicate the last column or row
+        for (; x < width; x += 2)
+        {
+            const size_t x1 = std::min(x + 1, width - 1);
+            y_top[x] = Luma(top[x]);
+            y_top[x1] = Luma(top[x1]);
+            y_bottom[x] = Luma(bottom[x]);
+            y_bottom[x1] = Luma(bottom[x1]);
+
+            const uint32_t quad[4] = {top[x], top[x1], bottom[x], bottom[x1]};
+            int r = 2, g = 2, b = 2;
+            for (uint32_t pixel : quad)
+            {
+                r += Red(pixel);
+                g += Green(pixel);
+                b += Blue(pixel);
+            }
+            u[x / 2] = ChromaU(r >> 2, g >> 2, b >> 2);
+            v[x / 2] = ChromaV(r >> 2, g >> 2, b >> 2);
+        }
+    }
+}
+
+VideoStream::VideoStream(ByteSink& sink, VideoFormat format, uint32_t fps)
+    : sink_(sink), format_(format), fps_(fps), width_(0), height_(0)
+{}
+
+int VideoStream::WriteFrame(const Image& frame)
+{
+    TRACE_SCOPE("VideoStream::WriteFrame");
+
+    if (frame.width == 0 || frame.height == 0)
+        return -1;
+
+    if (width_ == 0)
+    {
+        width_ = frame.width;
+        height_ = frame.height;
+
+        if (format_ == VideoFormat::Y4M)
+        {
+            const std::string header = "YUV4MPEG2 W" + std::to_string(width_) + " H" +
+                                       std::to_string(height_) + " F" + std::to_string(fps_) +
+                                       ":1 Ip A1:1 C420jpeg\n";
+            if (sink_.Write(header.data(), header.size()) != 0)
+                return -1;
+        }
+    }
+    else if (frame.width != width_ || frame.height != height_)
+    {
+        ERROR("VideoStream: frame size changed from %zux%zu to %zux%zu\n", width_, height_,
+              frame.width, frame.height);
+        return -1;
+    }
+
+    return format_ == VideoFormat::Y4M ? WriteY4MFrame(frame) : WritePPMFrame(frame);
+}
+
+int VideoStream::Flush()
+{
+    return sink_.Flush();
+}
+
+int VideoStream::WriteY4MFrame(const Image& frame)
+{
+    const size_t header_size = sizeof(Y4M_FRAME_HEADER) - 1;
+    const size_t luma_size = width_ * height_;
+    const size_t chroma_size = ((width_ + 1) / 2) * ((height_ + 1) / 2);
+    buffer_.resize(header_size + luma_size + 2 * chroma_size);
+
+    uint8_t* y_plane = buffer_.data() + header_size;
+    memcpy(buffer_.data(), Y4M_FRAME_HEADER, header_size);
+    ConvertToYUV420(frame.Data(), width_, height_, y_plane, y_plane + luma_size,
+                    y_plane + luma_size + chroma_size);
+
+    return sink_.Write(buffer_.data(), buffer_.size());
+}
+
+int VideoStream::WritePPMFrame(const Image& frame)
+{
+    const std::string header =
+        "P6\n" + std::to_string(width_) + " " + std::to_string(height_) + "\n255\n";
+    buffer_.resize(header.size() + 3 * width_ * height_);
+
+    memcpy(buffer_.data(), header.data(), header.size());
+    SwapRedBlue(frame.Data(), buffer_.data() + header.size(), width_ * height_);
+
+    return sink_.Write(buffer_.data(), buffer_.size());
+}
+
+int OpenVideoOutput(const char* path, FileSink& sink)
+{
+    if (strcmp(path, "-") != 0)
+        return sink.Open(path);
+
+#ifdef _WIN32
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    return sink.Open(stdout);
+}
+
+} // namespace sr
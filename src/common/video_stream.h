@@ -0,0 +1,55 @@
+#ifndef _VIDEO_STREAM_H_
+#define _VIDEO_STREAM_H_
+
+#include <vector>
+
+#include "byte_sink.h"
+#include "canvas.h"
+
+namespace sr
+{
+
+enum class VideoFormat
+{
+    Y4M, // YUV4MPEG2 with 4:2:0 chroma, understood by ffmpeg, x264, mpv
+    PPM  // concatenated binary PPM images, e.g. for ffmpeg -f image2pipe
+};
+
+// Continuous stream of equally sized frames, e.g. piped into an external encoder through stdout
+class VideoStream
+{
+  public:
+    VideoStream(ByteSink& sink, VideoFormat format, uint32_t fps = 30);
+
+    uint32_t Fps() const
+    {
+        return fps_;
+    }
+
+    // The first frame fixes the size of the stream
+    int WriteFrame(const Image& frame);
+    int Flush();
+
+  private:
+    int WriteY4MFrame(const Image& frame);
+    int WritePPMFrame(const Image& frame);
+
+    ByteSink& sink_;
+    VideoFormat format_;
+    uint32_t fps_;
+    size_t width_;
+    size_t height_;
+    std::vector<uint8_t> buffer_;
+};
+
+// Converts top to bottom BGRA rows to BT.601 limited range Y, U and V planes, chroma planes have
+// (width + 1) / 2 by (height + 1) / 2 samples
+void ConvertToYUV420(const uint32_t* pixels, size_t width, size_t height, uint8_t* y_plane,
+                     uint8_t* u_plane, uint8_t* v_plane);
+
+// Opens a file for a video stream, "-" stands for stdout
+int OpenVideoOutput(const char* path, FileSink& sink);
+
+} // namespace sr
+
+#endif
@@ -3,6 +3,7 @@
 #include "../renderer/model.h"
 
 #include <cmath>
+#include <cstring>
 
 using namespace sr;
 
@@ -49,6 +50,14 @@ void PrintControls()
 {
     std::cout << "Use ARROWS to rotate cube.\n";
 }
+
+void PrintUsage()
+{
+    std::cerr << "Usage: cube [--stats] [--trace FILE] [--y4m|--ppm OUTPUT [FRAMES]]\n"
+                 "OUTPUT may be - for stdout, e.g. cube --y4m - 300 | ffplay -\n"
+                 "--stats draws frame time percentiles over the frames\n"
+                 "--trace writes a Chrome trace, needs a build with SR_ENABLE_TRACING\n";
+}
 } // namespace
 
 class Demo
@@ -68,18 +77,18 @@ class Demo
 
     int Load()
     {
-        int status = LoadTGA(TEXTURE_PATH.c_str(), texture_);
+        int status = LoadTexture(TEXTURE_PATH.c_str(), texture_);
         if (status != 0)
             ERROR("Could not load texture: %s\n", TEXTURE_PATH.c_str());
 
-        PrintControls();
-
         return status;
     }
 
     void Init(Renderer& renderer)
     {
         camera_.LookAt(Vec3f{0.0f, 0.0f, 0.0f}, Vec3f{0.0f, 1.0f, 1.5f});
+        // the cube is closed, so faces turned away are always hidden
+        renderer.SetBackFaceCulling(true);
     }
 
     void Process(Renderer& renderer, Input& input)
@@ -115,15 +124,46 @@ class Demo
   private:
     const std::vector<Face> cube_;
     Camera camera_;
-    Image texture_;
+    Texture texture_;
 
     float angle_ = 0.0f;
     float x_angle_ = 0.0f;
     float z_angle_ = 0.0f;
 };
 
-int main()
+int main(int argc, char** argv)
 {
+    bool is_stats_enabled = false;
+    std::string trace_path;
+    while (argc > 1)
+    {
+        if (strcmp(argv[1], "--stats") == 0)
+        {
+            is_stats_enabled = true;
+            --argc;
+            ++argv;
+        }
+        else if (strcmp(argv[1], "--trace") == 0 && argc > 2)
+        {
+            trace_path = argv[2];
+            argc -= 2;
+            argv += 2;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    const bool is_headless = argc > 1;
+    const bool is_y4m = is_headless && strcmp(argv[1], "--y4m") == 0;
+    const bool is_ppm = is_headless && strcmp(argv[1], "--ppm") == 0;
+    if (is_headless && ((!is_y4m && !is_ppm) || argc < 3 || argc > 4))
+    {
+        PrintUsage();
+        return -1;
+    }
+
     Demo demo;
 
     if (int status = demo.Load(); status != 0)
@@ -135,5 +175,29 @@ int main()
     auto Process = [&demo](Renderer& renderer, Input& input) { demo.Process(renderer, input); };
     auto Draw = [&demo](Renderer& renderer) { demo.Draw(renderer); };
 
-    return Program(Init, Process, Draw).Run(demo.Width, demo.Height, demo.Caption);
+    Program program(Init, Process, Draw);
+    program.is_stats_overlay_enabled = is_stats_enabled;
+    program.trace_path = trace_path;
+
+    if (!is_headless)
+    {
+        PrintControls();
+
+        // Draw reads only matrices and constant data, so no snapshot callback is needed
+        program.is_pipelined = true;
+        program.swap_chain_length = 3;
+        return program.Run(demo.Width, demo.Height, demo.Caption);
+    }
+
+    FileSink sink;
+    if (OpenVideoOutput(argv[2], sink) != 0)
+    {
+        ERROR("Could not open output: %s\n", argv[2]);
+        return -1;
+    }
+
+    // one frame per processing step, so that the animation runs at its normal speed
+    const size_t frames = argc > 3 ? std::stoul(argv[3]) : 300;
+    VideoStream stream(sink, is_y4m ? VideoFormat::Y4M : VideoFormat::PPM, 50);
+    return program.RunHeadless(demo.Width, demo.Height, frames, stream);
 }
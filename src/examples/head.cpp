@@ -52,7 +52,11 @@ class Demo
         }
         model_.Normalize();
 
-        status = LoadTGA(texture_name.c_str(), texture_);
+        BuildLods(model_, lods_);
+        for (size_t i = 0; i < lods_.levels.size(); ++i)
+            LOG("LOD %zu: %zu faces\n", i, lods_.levels[i].model.faces.size());
+
+        status = LoadTexture(texture_name.c_str(), texture_);
         if (status != 0)
         {
             ERROR("Failed to texture_ %s\n", texture_name.c_str());
@@ -114,13 +118,7 @@ class Demo
         renderer.Clear();
 
         renderer.SetShader(*used_shader);
-        for (auto face = model_.faces.begin(); face != model_.faces.end(); ++face)
-        {
-            const Vertex& v1 = face->v[0];
-            const Vertex& v2 = face->v[1];
-            const Vertex& v3 = face->v[2];
-            renderer.Triangle(v1, v2, v3);
-        }
+        renderer.DrawModel(lods_);
     }
 
   private:
@@ -141,13 +139,14 @@ class Demo
     }
 
     Model model_;
-    Image texture_;
+    LodChain lods_;
+    Texture texture_;
     Camera camera_;
     Vec3f light_direction_ = Vec3f{0.0f, 0.0f, -1.0f};
 
     DefaultShaders::SmoothLight colored_shader_;
     DefaultShaders::SmoothTexture textured_shader_;
-    Shader* used_shader;
+    const Shader* used_shader;
 };
 
 int main()
@@ -5,6 +5,7 @@
 #include "../renderer/camera.h"
 #include "../renderer/definitions.h"
 #include "../renderer/model.h"
+#include "../renderer/wireframe.h"
 
 using namespace sr;
 
@@ -34,6 +35,8 @@ class Demo
         }
 
         model_.Normalize();
+        BuildEdgeMesh(model_, edges_);
+        LOG("%zu edges of %zu faces\n", edges_.EdgeCount(), model_.faces.size());
 
         LOG("Loaded succesfully\n");
 
@@ -62,17 +65,12 @@ class Demo
         renderer.Matrices.SetView(camera_.ViewMatrix());
 
         renderer.Clear();
-        for (auto face = model_.faces.begin(); face != model_.faces.end(); ++face)
-        {
-            Vec3f v1 = face->v[0].coord;
-            Vec3f v2 = face->v[1].coord;
-            Vec3f v3 = face->v[2].coord;
-            renderer.TriangleFrame(v1, v2, v3, COLOR);
-        }
+        renderer.DrawWireframe(edges_, COLOR);
     }
 
   private:
     Model model_;
+    EdgeMesh edges_;
     Camera camera_;
 
     float angle_ = 0.0f;
@@ -91,5 +89,9 @@ int main()
     auto Process = [&demo](Renderer& renderer, Input& input) { demo.Process(renderer, input); };
     auto Draw = [&demo](Renderer& renderer) { demo.Draw(renderer); };
 
-    return Program(Init, Process, Draw).Run(demo.Width, demo.Height, demo.Caption);
+    // large models are drawn at a lower resolution instead of dropping below 30 fps
+    Program program(Init, Process, Draw);
+    program.is_dynamic_resolution_enabled = true;
+    program.target_frame_ms = 1000.0f / 30.0f;
+    return program.Run(demo.Width, demo.Height, demo.Caption);
 }
@@ -3,6 +3,7 @@
 #include "../renderer/model.h"
 
 #include <cmath>
+#include <optional>
 
 using namespace sr;
 
@@ -0,0 +1,41 @@
+#ifndef _PLATFORM_FILE_H_
+#define _PLATFORM_FILE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace sr
+{
+
+// Read-only view of a whole file mapped into memory
+class MappedFile
+{
+  public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    int Open(const char* path);
+    void Close();
+
+    const uint8_t* Data() const
+    {
+        return data_;
+    }
+
+    size_t Size() const
+    {
+        return size_;
+    }
+
+  private:
+    const uint8_t* data_;
+    size_t size_;
+    void* handle_;
+};
+
+} // namespace sr
+
+#endif
@@ -0,0 +1,54 @@
+#include "../file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sr
+{
+
+MappedFile::MappedFile() : data_(nullptr), size_(0), handle_(nullptr)
+{}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+int MappedFile::Open(const char* path)
+{
+    Close();
+
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    void* data = mmap(nullptr, (size_t)(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return -1;
+
+    madvise(data, (size_t)(info.st_size), MADV_SEQUENTIAL);
+
+    data_ = static_cast<const uint8_t*>(data);
+    size_ = (size_t)(info.st_size);
+    return 0;
+}
+
+void MappedFile::Close()
+{
+    if (data_ != nullptr)
+        munmap(const_cast<uint8_t*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+}
+
+} // namespace sr
@@ -5,10 +5,12 @@
 namespace sr
 {
 
+// clock() is CPU time of the process, which stands still while sleeping
 uint32_t GetTimeMs()
 {
-    static const clock_t CLOCKS_PER_MS = CLOCKS_PER_SEC / 1000;
-    return (uint32_t)(clock() / CLOCKS_PER_MS);
+    timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint32_t)(time.tv_sec * 1000 + time.tv_nsec / 1000000);
 }
 
 } // namespace sr
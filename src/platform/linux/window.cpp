@@ -4,15 +4,26 @@
 
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
+#include <poll.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
 
 #include "convert_key.h"
 
 namespace
 {
-const size_t BYTES_PER_PIXEL = 3;
-const size_t PITCH = 8;
+const size_t BITMAP_PAD = 32;
 const size_t WINDOW_BORDER_WIDTH = 5;
 
+// attaching a segment fails asynchronously, e.g. on a remote display
+bool shm_attach_failed = false;
+
+int HandleShmAttachError(Display*, XErrorEvent*)
+{
+    shm_attach_failed = true;
+    return 0;
+}
+
 struct ParseButtonEventResult
 {
     unsigned long keycode;
@@ -43,28 +54,34 @@ namespace sr
 {
 
 Window::Window(GetFrameFunc get_frame, Input& input)
-    : closed_(true), get_frame_(get_frame), input_(input)
+    : closed_(true), display_(nullptr), image_(nullptr), shm_completion_event_(-1),
+      get_frame_(get_frame), input_(input)
 {}
 
+Window::~Window()
+{
+    DestroyImages();
+}
+
 bool Window::IsClosed() const
 {
     return closed_;
 }
 
-int Window::Create(size_t width, size_t height, const std::string& caption)
+int Window::Create(size_t width, size_t height, const std::string& caption, size_t buffer_count)
 {
     closed_ = false;
 
     display_ = XOpenDisplay(NULL);
     visual_ = DefaultVisual(display_, 0);
-    const int depth = DefaultDepth(display_, 0);
+    depth_ = DefaultDepth(display_, 0);
 
     XSetWindowAttributes attributes;
     attributes.background_pixel = XBlackPixel(display_, 0);
 
     window_ =
         XCreateWindow(display_, XRootWindow(display_, 0), 0, 0, width, height, WINDOW_BORDER_WIDTH,
-                      depth, InputOutput, visual_, CWBackPixel, &attributes);
+                      depth_, InputOutput, visual_, CWBackPixel, &attributes);
 
     SetCaption(caption);
 
@@ -77,7 +94,7 @@ int Window::Create(size_t width, size_t height, const std::string& caption)
 
     SubscribeToWindowClosing();
 
-    CreateImageBuffer(width, height);
+    CreateImageBuffer(width, height, buffer_count);
 
     XMapWindow(display_, window_);
 
@@ -86,13 +103,149 @@ int Window::Create(size_t width, size_t height, const std::string& caption)
     return 0;
 }
 
-void Window::CreateImageBuffer(size_t width, size_t height)
+void Window::CreateImageBuffer(size_t width, size_t height, size_t buffer_count)
 {
     width_ = width;
     height_ = height;
-    stride_ = (width + PITCH - 1) / PITCH * PITCH;
-    const size_t size = stride_ * height * sizeof(uint32_t);
-    image_buffer_ = std::unique_ptr<uint8_t[]>(new uint8_t[size]);
+
+    for (size_t i = 0; i < buffer_count; ++i)
+    {
+        if (!CreateSharedImage(width, height))
+        {
+            DestroyImages();
+            break;
+        }
+    }
+
+    if (!shared_images_.empty())
+    {
+        shm_completion_event_ = XShmGetEventBase(display_) + ShmCompletion;
+        return;
+    }
+
+    // without shared memory the image points to the frame itself, see HandleExpose
+    image_ = XCreateImage(display_, visual_, depth_, ZPixmap, 0, nullptr, width, height,
+                          BITMAP_PAD, width * sizeof(uint32_t));
+}
+
+bool Window::CreateSharedImage(size_t width, size_t height)
+{
+    if (!XShmQueryExtension(display_))
+        return false;
+
+    SharedImage shared = {};
+    XImage* image =
+        XShmCreateImage(display_, visual_, depth_, ZPixmap, nullptr, &shared.info, width, height);
+    if (image == nullptr)
+        return false;
+
+    // frames are drawn straight into the segment, so its layout must be the one of Image
+    if (image->bits_per_pixel != 32 || image->bytes_per_line != (int)(width * sizeof(uint32_t)))
+    {
+        XDestroyImage(image);
+        return false;
+    }
+
+    XShmSegmentInfo& info = shared.info;
+    info.shmid = shmget(IPC_PRIVATE, image->bytes_per_line * height, IPC_CREAT | 0600);
+    info.shmaddr = info.shmid < 0 ? (char*)(-1) : (char*)(shmat(info.shmid, 0, 0));
+    info.readOnly = False;
+    if (info.shmaddr == (char*)(-1))
+    {
+        if (info.shmid >= 0)
+            shmctl(info.shmid, IPC_RMID, nullptr);
+        XDestroyImage(image);
+        return false;
+    }
+    image->data = info.shmaddr;
+
+    shm_attach_failed = false;
+    XErrorHandler previous_handler = XSetErrorHandler(HandleShmAttachError);
+    const bool attached = XShmAttach(display_, &info) && (XSync(display_, False), true);
+    XSetErrorHandler(previous_handler);
+
+    // the segment goes away as soon as both sides detach
+    shmctl(info.shmid, IPC_RMID, nullptr);
+
+    if (!attached || shm_attach_failed)
+    {
+        WARNING("MIT-SHM is not available, falling back to XPutImage\n");
+        shmdt(info.shmaddr);
+        image->data = nullptr;
+        XDestroyImage(image);
+        return false;
+    }
+
+    shared.image = image;
+    shared_images_.push_back(shared);
+    return true;
+}
+
+void Window::DestroyImages()
+{
+    for (SharedImage& shared : shared_images_)
+    {
+        XShmDetach(display_, &shared.info);
+        XSync(display_, False);
+        shmdt(shared.info.shmaddr);
+        shared.image->data = nullptr;
+        XDestroyImage(shared.image);
+    }
+    shared_images_.clear();
+
+    // the data of the fallback image belongs to the frame
+    if (image_ != nullptr)
+    {
+        image_->data = nullptr;
+        XDestroyImage(image_);
+        image_ = nullptr;
+    }
+}
+
+uint32_t* Window::SharedBuffer(size_t index) const
+{
+    return index < shared_images_.size() ? (uint32_t*)(shared_images_[index].image->data)
+                                         : nullptr;
+}
+
+Window::SharedImage* Window::FindSharedImage(const Image& frame)
+{
+    for (SharedImage& shared : shared_images_)
+    {
+        if ((const uint32_t*)(shared.image->data) == frame.Data())
+            return &shared;
+    }
+    return nullptr;
+}
+
+void Window::OnPresentCompleted(const XEvent& event)
+{
+    const auto& completion = *reinterpret_cast<const XShmCompletionEvent*>(&event);
+    for (SharedImage& shared : shared_images_)
+    {
+        if (shared.info.shmseg == completion.shmseg && shared.pending > 0)
+            --shared.pending;
+    }
+}
+
+void Window::WaitPresented(SharedImage& shared)
+{
+    const auto is_completion = [](Display*, XEvent* event, XPointer arg) -> Bool {
+        return event->type == *(const int*)(arg);
+    };
+
+    while (shared.pending > 0)
+    {
+        XEvent event;
+        XIfEvent(display_, &event, is_completion, (XPointer)(&shm_completion_event_));
+        OnPresentCompleted(event);
+    }
+}
+
+void Window::WaitPresented(const Image& frame)
+{
+    if (SharedImage* shared = FindSharedImage(frame))
+        WaitPresented(*shared);
 }
 
 void Window::PreventResizing() const
@@ -117,17 +270,29 @@ void Window::SetCaption(const std::string& string)
     XStoreName(display_, window_, string.c_str());
 }
 
-void Window::HandleExpose() const
+void Window::HandleExpose()
 {
-    const int screen_num = DefaultScreen(display_);
-
     Canvas<uint32_t>& frame = get_frame_();
 
-    frame.CopyWithStride((uint32_t*)(image_buffer_.get()), stride_);
-    XImage* img = XCreateImage(display_, visual_, 8 * BYTES_PER_PIXEL, ZPixmap, 0,
-                               (char*)(image_buffer_.get()), width_, height_, PITCH, 0);
-    XPutImage(display_, window_, DefaultGC(display_, screen_num), img, 0, 0, 0, 0, width_, height_);
-    XFree(img);
+    if (shared_images_.empty())
+    {
+        image_->data = (char*)(frame.Data());
+        XPutImage(display_, window_, gc_, image_, 0, 0, 0, 0, width_, height_);
+        image_->data = nullptr;
+        return;
+    }
+
+    // the frame may live outside of the segments, e.g. after a FrameWriter swapped it out
+    SharedImage* shared = FindSharedImage(frame);
+    if (shared == nullptr)
+    {
+        shared = &shared_images_[0];
+        WaitPresented(*shared);
+        frame.CopyTo((uint32_t*)(shared->image->data), width_ * height_);
+    }
+
+    XShmPutImage(display_, window_, gc_, shared->image, 0, 0, 0, 0, width_, height_, True);
+    ++shared->pending;
 }
 
 void Window::MainLoopRoutine()
@@ -142,6 +307,9 @@ void Window::MainLoopRoutine()
 
         XNextEvent(display_, &event);
 
+        if (event.type == shm_completion_event_)
+            OnPresentCompleted(event);
+
         switch (event.type)
         {
         case Expose:
@@ -198,6 +366,23 @@ void Window::MainLoopRoutine()
     }
 }
 
+void Window::WaitEvents(int64_t timeout_us)
+{
+    // also flushes requests, so the server sees them before we sleep
+    if (XPending(display_) > 0)
+        return;
+
+    pollfd connection = {ConnectionNumber(display_), POLLIN, 0};
+    if (timeout_us < 0)
+    {
+        ppoll(&connection, 1, nullptr, nullptr);
+        return;
+    }
+
+    const timespec timeout = {(time_t)(timeout_us / 1000000), (long)(timeout_us % 1000000) * 1000};
+    ppoll(&connection, 1, &timeout, nullptr);
+}
+
 void Window::Redraw()
 {
     XEvent event;
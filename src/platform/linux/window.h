@@ -4,8 +4,10 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <X11/Xlib.h>
+#include <X11/extensions/XShm.h>
 
 #include "../../common/canvas.h" // TODO: move Image to common code
 #include "../../common/input.h"
@@ -19,17 +21,39 @@ class Window
     using GetFrameFunc = std::function<Image&(void)>;
 
     Window(GetFrameFunc get_frame, Input& input);
+    ~Window();
 
-    int Create(size_t width, size_t height, const std::string& caption);
+    // buffer_count is the number of frames that can be presented without a copy
+    int Create(size_t width, size_t height, const std::string& caption, size_t buffer_count = 1);
     void SetCaption(const std::string& caption);
     void MainLoopRoutine();
+    // Blocks until there are window events or timeout_us passes, negative timeout waits forever
+    void WaitEvents(int64_t timeout_us);
     void Redraw();
 
     bool IsClosed() const;
 
+    // Pixels of an MIT-SHM segment the server presents from, nullptr without the extension.
+    // Frames wrapping them are presented without any copy.
+    uint32_t* SharedBuffer(size_t index) const;
+    // Blocks until the server has finished reading frame, so that it can be drawn again
+    void WaitPresented(const Image& frame);
+
   private:
-    void HandleExpose() const;
-    void CreateImageBuffer(size_t width, size_t height);
+    struct SharedImage
+    {
+        ::XImage* image;
+        ::XShmSegmentInfo info;
+        size_t pending; // presents the server has not completed yet
+    };
+
+    void HandleExpose();
+    void CreateImageBuffer(size_t width, size_t height, size_t buffer_count);
+    bool CreateSharedImage(size_t width, size_t height);
+    void DestroyImages();
+    SharedImage* FindSharedImage(const Image& frame);
+    void OnPresentCompleted(const XEvent& event);
+    void WaitPresented(SharedImage& shared);
     void PreventResizing() const;
     void SubscribeToWindowClosing();
 
@@ -39,10 +63,12 @@ class Window
     ::Window window_;
     ::GC gc_;
     ::Atom wm_delete_message_;
-    std::unique_ptr<uint8_t[]> image_buffer_;
+    int depth_;
+    ::XImage* image_;
+    std::vector<SharedImage> shared_images_;
+    int shm_completion_event_;
     size_t width_;
     size_t height_;
-    size_t stride_;
 
     GetFrameFunc get_frame_;
     Input& input_;
@@ -0,0 +1,61 @@
+#include "../file.h"
+
+#include <windows.h>
+
+namespace sr
+{
+
+MappedFile::MappedFile() : data_(nullptr), size_(0), handle_(nullptr)
+{}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+int MappedFile::Open(const char* path)
+{
+    Close();
+
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return -1;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return -1;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL)
+        return -1;
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL)
+    {
+        CloseHandle(mapping);
+        return -1;
+    }
+
+    data_ = static_cast<const uint8_t*>(data);
+    size_ = (size_t)(size.QuadPart);
+    handle_ = mapping;
+    return 0;
+}
+
+void MappedFile::Close()
+{
+    if (data_ != nullptr)
+        UnmapViewOfFile(data_);
+    if (handle_ != nullptr)
+        CloseHandle(static_cast<HANDLE>(handle_));
+    data_ = nullptr;
+    size_ = 0;
+    handle_ = nullptr;
+}
+
+} // namespace sr
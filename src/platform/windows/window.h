@@ -39,7 +39,7 @@ class Window
         return closed_;
     }
 
-    int Create(size_t width, size_t height, const std::string& caption)
+    int Create(size_t width, size_t height, const std::string& caption, size_t buffer_count = 1)
     {
         hinstance_ = GetModuleHandle(NULL);
 
@@ -99,11 +99,27 @@ class Window
         return 0;
     }
 
+    // Blocks until there are window messages or timeout_us passes, negative timeout waits forever
+    void WaitEvents(int64_t timeout_us)
+    {
+        const DWORD timeout = timeout_us < 0 ? INFINITE : (DWORD)((timeout_us + 999) / 1000);
+        MsgWaitForMultipleObjects(0, NULL, FALSE, timeout, QS_ALLINPUT);
+    }
+
     void Redraw()
     {
         RedrawWindow(hwnd_, NULL, NULL, RDW_ERASE | RDW_INVALIDATE);
     }
 
+    // GDI has no shared present path, WM_PAINT always copies the frame
+    uint32_t* SharedBuffer(size_t index) const
+    {
+        return nullptr;
+    }
+
+    void WaitPresented(const Image& frame)
+    {}
+
     void SetCaption(std::string& text)
     {
         SetWindowText(hwnd_, text.c_str());
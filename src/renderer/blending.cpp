@@ -0,0 +1,88 @@
+#include "blending.h"
+
+#include <algorithm>
+
+namespace sr
+{
+
+namespace
+{
+// Weight of equation 9 of the paper, computed from the window-space depth
+float OitWeight(float depth, float alpha)
+{
+    const float d = 1.0f - std::clamp(depth, 0.0f, 1.0f);
+    return alpha * std::clamp(3e3f * d * d * d, 1e-2f, 3e3f);
+}
+} // namespace
+
+void OitBuffers::Resize(size_t width, size_t height)
+{
+    if (width != accumulation_.width || height != accumulation_.height)
+    {
+        accumulation_.Resize(width, height);
+        revealage_.Resize(width, height);
+    }
+}
+
+void OitBuffers::Clear()
+{
+    accumulation_.FillBlack();
+    revealage_.Fill(1.0f);
+}
+
+void OitBuffers::Accumulate(size_t x, size_t y, float depth, Color color)
+{
+    if (color.a == 0)
+        return;
+
+    const float alpha = color.a / 255.0f;
+    // premultiplied color and alpha times the weight
+    const float weight = alpha * OitWeight(depth, alpha);
+    const float scale = weight / 255.0f;
+
+    Vec4f& sum = accumulation_.At(x, y);
+    sum.x += color.r * scale;
+    sum.y += color.g * scale;
+    sum.z += color.b * scale;
+    sum.w += weight;
+    revealage_.At(x, y) *= 1.0f - alpha;
+}
+
+size_t OitBuffers::Width() const
+{
+    return accumulation_.width;
+}
+
+size_t OitBuffers::Height() const
+{
+    return accumulation_.height;
+}
+
+void ResolveOit(const OitBuffers& buffers, Image& target)
+{
+    if (buffers.Width() != target.width || buffers.Height() != target.height)
+        return;
+
+    // all three canvases have the same memory layout
+    const Vec4f* accumulation = buffers.accumulation_.Data();
+    const float* revealage = buffers.revealage_.Data();
+    uint32_t* pixels = target.Data();
+
+    for (size_t i = 0; i < target.width * target.height; ++i)
+    {
+        const float reveal = revealage[i];
+        if (reveal >= 1.0f)
+            continue;
+
+        const Vec4f& sum = accumulation[i];
+        const float coverage = (1.0f - reveal) * 255.0f / std::max(sum.w, 1e-5f);
+
+        Color color = pixels[i];
+        color.r = (uint8_t)(std::min(255.0f, sum.x * coverage + color.r * reveal + 0.5f));
+        color.g = (uint8_t)(std::min(255.0f, sum.y * coverage + color.g * reveal + 0.5f));
+        color.b = (uint8_t)(std::min(255.0f, sum.z * coverage + color.b * reveal + 0.5f));
+        pixels[i] = color;
+    }
+}
+
+} // namespace sr
@@ -0,0 +1,66 @@
+#ifndef _BLENDING_H_
+#define _BLENDING_H_
+
+#include "../common/canvas.h"
+#include "geometry.h"
+
+namespace sr
+{
+
+enum class BlendMode
+{
+    OPAQUE,   // overwrites the color and the depth
+    ALPHA,    // src * alpha + dst * (1 - alpha)
+    ADDITIVE, // dst + src * alpha
+    MULTIPLY, // dst * src
+    // Weighted blended order-independent transparency: pixels are accumulated in any order and
+    // composited onto the target by ResolveOit
+    WEIGHTED_OIT
+};
+
+// Accumulation and revealage targets of weighted blended OIT (McGuire and Bavoil, 2013). The
+// accumulation holds the sums of premultiplied colors and alphas times the depth weights, the
+// revealage the product of (1 - alpha), i.e. how much of the background stays visible.
+class OitBuffers
+{
+  public:
+    void Resize(size_t width, size_t height);
+    void Clear();
+
+    // depth is normalized to [0, 1], nearer pixels get larger weights
+    void Accumulate(size_t x, size_t y, float depth, Color color);
+
+    size_t Width() const;
+    size_t Height() const;
+
+  private:
+    Canvas<Vec4f> accumulation_;
+    Canvas<float> revealage_;
+
+    friend void ResolveOit(const OitBuffers& buffers, Image& target);
+};
+
+// Composites the average accumulated color over the target, weighted by the revealage. The
+// buffers must be of the target size.
+void ResolveOit(const OitBuffers& buffers, Image& target);
+
+enum class DepthTest
+{
+    LESS,
+    // also passes pixels at the depth already in the buffer, for the shading pass after a depth
+    // prepass of the same geometry
+    LESS_EQUAL
+};
+
+// Blending of the pixels written by the rasterizer. Blended pixels are depth tested but do not
+// write the depth, so the opaque geometry should be drawn first.
+struct BlendState
+{
+    BlendMode mode = BlendMode::OPAQUE;
+    OitBuffers* oit = nullptr; // required by WEIGHTED_OIT
+    DepthTest depth_test = DepthTest::LESS;
+};
+
+} // namespace sr
+
+#endif
@@ -14,8 +14,9 @@ enum
     BACK = 0x10,
     FRONT = 0x20
 };
+} // namespace
 
-static uint8_t PositionCode(Vec3f p1, Boxf box)
+uint8_t ClipCode(const Vec3f& p1, const Boxf& box)
 {
     uint8_t code = 0;
     if (p1.x < box.xmin)
@@ -32,12 +33,11 @@ static uint8_t PositionCode(Vec3f p1, Boxf box)
         code |= FRONT;
     return code;
 }
-} // namespace
 
 bool ClipLine(Vec3f p1, Vec3f p2, Boxf box, Vec3f& res1, Vec3f& res2)
 {
-    uint8_t code1 = PositionCode(p1, box);
-    uint8_t code2 = PositionCode(p2, box);
+    uint8_t code1 = ClipCode(p1, box);
+    uint8_t code2 = ClipCode(p2, box);
 
     while (true)
     {
@@ -97,7 +97,7 @@ bool ClipLine(Vec3f p1, Vec3f p2, Boxf box, Vec3f& res1, Vec3f& res2)
                 point.y = p1.y + coef * (p2.y - p1.y);
                 point.z = box.zmax;
             }
-            code = PositionCode(point, box);
+            code = ClipCode(point, box);
         }
     }
 }
@@ -7,6 +7,9 @@
 
 namespace sr
 {
+// Cohen-Sutherland outcode of the point, 0 inside of the box. Lines whose endpoint codes have a
+// common bit are outside, lines with both codes 0 are inside and need no clipping.
+uint8_t ClipCode(const Vec3f& p1, const Boxf& box);
 bool ClipLine(Vec3f p1, Vec3f p2, Boxf box, Vec3f& res1, Vec3f& res2);
 bool TriangleClip(Vec3f p1, Vec3f p2, Vec3f p3, Boxf box, Vec3f& res11, Vec3f& res12, Vec3f& res21,
                   Vec3f& res22, Vec3f& res31, Vec3f& res32);
@@ -0,0 +1,263 @@
+#include "deferred.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+#include "../common/trace.h"
+
+namespace sr
+{
+
+namespace
+{
+const float OCT_SCALE = 65534.0f;
+
+float SignNotZero(float value)
+{
+    return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+uint32_t Quantize(float value)
+{
+    return (uint32_t)((std::clamp(value, -1.0f, 1.0f) * 0.5f + 0.5f) * OCT_SCALE + 0.5f) + 1;
+}
+
+float Dequantize(uint32_t value)
+{
+    return (float)(value - 1) / OCT_SCALE * 2.0f - 1.0f;
+}
+
+Vec3f ToView(const Mat4f& screen_to_view, float x, float y, float z)
+{
+    const Vec4f view = screen_to_view * Vec4f{x, y, z, 1.0f};
+    return Project<3, float>(view) / view.w;
+}
+
+// distance from the sphere center to the box against the radius
+bool SphereTouchesBox(const Vec3f& center, float radius, const Boxf& box)
+{
+    const float dx = std::max({box.xmin - center.x, 0.0f, center.x - box.xmax});
+    const float dy = std::max({box.ymin - center.y, 0.0f, center.y - box.ymax});
+    const float dz = std::max({box.zmin - center.z, 0.0f, center.z - box.zmax});
+    return dx * dx + dy * dy + dz * dz <= radius * radius;
+}
+
+struct TileJob
+{
+    const GBuffer& gbuffer;
+    const Canvas<float>& depth;
+    const Mat4f& screen_to_view;
+    const std::vector<Light>& lights;
+    const Vec3f& ambient;
+    Image& target;
+    size_t tiles_x;
+    std::vector<uint32_t>& counts;
+};
+
+void ShadeTile(const TileJob& job, size_t tile, std::vector<uint32_t>& tile_lights)
+{
+    const size_t size = TiledLighting::TILE_SIZE;
+    const size_t x0 = (tile % job.tiles_x) * size;
+    const size_t y0 = (tile / job.tiles_x) * size;
+    const size_t x1 = std::min(x0 + size, job.target.width);
+    const size_t y1 = std::min(y0 + size, job.target.height);
+
+    // depth range of the covered pixels
+    float zmin = std::numeric_limits<float>::max();
+    float zmax = -std::numeric_limits<float>::max();
+    for (size_t y = y0; y < y1; ++y)
+    {
+        for (size_t x = x0; x < x1; ++x)
+        {
+            if (job.gbuffer.normals.At(x, y) == 0)
+                continue;
+            const float z = job.depth.At(x, y);
+            zmin = std::min(zmin, z);
+            zmax = std::max(zmax, z);
+        }
+    }
+
+    job.counts[tile] = 0;
+    if (zmin > zmax)
+        return;
+
+    // the part of the tile frustum between the depths is the hull of these corners
+    Boxf box = {std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(),
+                std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(),
+                std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()};
+    for (size_t i = 0; i < 8; ++i)
+    {
+        const Vec3f corner = ToView(job.screen_to_view, (float)(i & 1 ? x1 : x0),
+                                    (float)(i & 2 ? y1 : y0), i & 4 ? zmax : zmin);
+        box.xmin = std::min(box.xmin, corner.x);
+        box.xmax = std::max(box.xmax, corner.x);
+        box.ymin = std::min(box.ymin, corner.y);
+        box.ymax = std::max(box.ymax, corner.y);
+        box.zmin = std::min(box.zmin, corner.z);
+        box.zmax = std::max(box.zmax, corner.z);
+    }
+
+    tile_lights.clear();
+    for (size_t i = 0; i < job.lights.size(); ++i)
+        if (SphereTouchesBox(job.lights[i].position, job.lights[i].radius, box))
+            tile_lights.push_back((uint32_t)(i));
+    job.counts[tile] = (uint32_t)(tile_lights.size());
+
+    for (size_t y = y0; y < y1; ++y)
+    {
+        for (size_t x = x0; x < x1; ++x)
+        {
+            const uint32_t encoded = job.gbuffer.normals.At(x, y);
+            if (encoded == 0)
+                continue;
+
+            const Vec3f position =
+                ToView(job.screen_to_view, x + 0.5f, y + 0.5f, job.depth.At(x, y));
+            const Vec3f normal = DecodeNormal(encoded);
+
+            Vec3f light = job.ambient;
+            for (uint32_t index : tile_lights)
+                light = light + LightContribution(job.lights[index], position, normal);
+
+            const Color albedo = job.gbuffer.albedo.At(x, y);
+            job.target.At(x, y) =
+                Color((uint8_t)(std::min(255.0f, albedo.r * light.x + 0.5f)),
+                      (uint8_t)(std::min(255.0f, albedo.g * light.y + 0.5f)),
+                      (uint8_t)(std::min(255.0f, albedo.b * light.z + 0.5f)));
+        }
+    }
+}
+} // namespace
+
+uint32_t EncodeNormal(const Vec3f& normal)
+{
+    const float sum = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+    if (sum == 0.0f)
+        return Quantize(0.0f) | Quantize(0.0f) << 16;
+
+    float u = normal.x / sum;
+    float v = normal.y / sum;
+    if (normal.z < 0.0f)
+    {
+        // the lower half of the octahedron is folded over the diagonals
+        const float folded_u = (1.0f - std::fabs(v)) * SignNotZero(u);
+        v = (1.0f - std::fabs(u)) * SignNotZero(v);
+        u = folded_u;
+    }
+    return Quantize(u) | Quantize(v) << 16;
+}
+
+Vec3f DecodeNormal(uint32_t encoded)
+{
+    const float u = Dequantize(encoded & 0xFFFF);
+    const float v = Dequantize(encoded >> 16);
+    Vec3f normal = {u, v, 1.0f - std::fabs(u) - std::fabs(v)};
+    if (normal.z < 0.0f)
+    {
+        normal.x = (1.0f - std::fabs(v)) * SignNotZero(u);
+        normal.y = (1.0f - std::fabs(u)) * SignNotZero(v);
+    }
+    return Normalize(normal);
+}
+
+void GBuffer::Resize(size_t width, size_t height)
+{
+    if (width != albedo.width || height != albedo.height)
+    {
+        albedo.Resize(width, height);
+        normals.Resize(width, height);
+    }
+}
+
+void GBuffer::Clear()
+{
+    albedo.FillBlack();
+    normals.FillBlack();
+}
+
+Vec3f LightContribution(const Light& light, const Vec3f& position, const Vec3f& normal)
+{
+    const Vec3f to_light = light.position - position;
+    const float distance2 = to_light * to_light;
+    const float radius2 = light.radius * light.radius;
+    if (distance2 >= radius2)
+        return Vec3f{0.0f, 0.0f, 0.0f};
+
+    const float distance = std::sqrt(distance2);
+    const float n_dot_l = distance > 0.0f ? normal * to_light / distance : 1.0f;
+    if (n_dot_l <= 0.0f)
+        return Vec3f{0.0f, 0.0f, 0.0f};
+
+    // falls to zero at the radius with a zero slope
+    const float fade = 1.0f - distance2 / radius2;
+    float attenuation = fade * fade * n_dot_l;
+
+    if (light.type == LightType::SPOT)
+    {
+        const float cos_angle = distance > 0.0f ? -(light.direction * to_light) / distance : 1.0f;
+        const float range = std::max(light.cos_inner - light.cos_outer, 1e-4f);
+        const float t = std::clamp((cos_angle - light.cos_outer) / range, 0.0f, 1.0f);
+        attenuation *= t * t * (3.0f - 2.0f * t);
+    }
+
+    return light.intensity * attenuation;
+}
+
+void TiledLighting::SetThreadCount(size_t count)
+{
+    thread_count_ = count;
+}
+
+void TiledLighting::Shade(const GBuffer& gbuffer, const Canvas<float>& depth,
+                          const Mat4f& screen_to_view, const std::vector<Light>& lights,
+                          const Vec3f& ambient, Image& target)
+{
+    TRACE_SCOPE("TiledLighting::Shade");
+
+    if (gbuffer.albedo.width != target.width || gbuffer.albedo.height != target.height ||
+        depth.width != target.width || depth.height != target.height)
+        return;
+
+    tiles_x_ = (target.width + TILE_SIZE - 1) / TILE_SIZE;
+    const size_t tiles_y = (target.height + TILE_SIZE - 1) / TILE_SIZE;
+    const size_t tile_count = tiles_x_ * tiles_y;
+    tile_light_counts_.resize(tile_count);
+
+    const TileJob job = {gbuffer, depth,  screen_to_view, lights,
+                         ambient, target, tiles_x_,       tile_light_counts_};
+
+    // tiles are taken one by one, so threads which got cheap tiles help with the rest
+    std::atomic<size_t> next_tile = 0;
+    auto work = [&job, &next_tile, tile_count]() {
+        std::vector<uint32_t> tile_lights;
+        for (size_t tile = next_tile++; tile < tile_count; tile = next_tile++)
+            ShadeTile(job, tile, tile_lights);
+    };
+
+    size_t thread_count = thread_count_;
+    if (thread_count == 0)
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    thread_count = std::min(thread_count, tile_count);
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < thread_count; ++i)
+        threads.emplace_back(work);
+    work();
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+const std::vector<uint32_t>& TiledLighting::TileLightCounts() const
+{
+    return tile_light_counts_;
+}
+
+size_t TiledLighting::TilesX() const
+{
+    return tiles_x_;
+}
+
+} // namespace sr
@@ -0,0 +1,83 @@
+#ifndef _DEFERRED_H_
+#define _DEFERRED_H_
+
+#include "../common/canvas.h"
+#include "geometry.h"
+
+#include <vector>
+
+namespace sr
+{
+
+// Normals packed into two 16 bit octahedral coordinates. 0 is never produced, it marks pixels
+// not covered by the G-buffer pass.
+uint32_t EncodeNormal(const Vec3f& normal);
+Vec3f DecodeNormal(uint32_t encoded);
+
+// Surface attributes written by the G-buffer pass, the depth stays in the renderer's z-buffer so
+// forward passes after the lighting are still depth tested
+class GBuffer
+{
+  public:
+    void Resize(size_t width, size_t height);
+    void Clear();
+
+    Image albedo;
+    Canvas<uint32_t> normals;
+};
+
+enum class LightType
+{
+    POINT,
+    SPOT
+};
+
+// Lights are given in view space, the space of the normals written to the G-buffer
+struct Light
+{
+    LightType type = LightType::POINT;
+    Vec3f position = Vec3f{0.0f, 0.0f, 0.0f};
+    // 1 lights the albedo fully
+    Vec3f intensity = Vec3f{1.0f, 1.0f, 1.0f};
+    // the light fades out smoothly and does not reach beyond the radius
+    float radius = 1.0f;
+
+    // spot lights only: the cone is fully lit up to the inner cosine and fades out to the outer
+    Vec3f direction = Vec3f{0.0f, 0.0f, -1.0f};
+    float cos_inner = 1.0f;
+    float cos_outer = 0.0f;
+};
+
+// Light reflected by a diffuse surface at the view space position with a unit normal
+Vec3f LightContribution(const Light& light, const Vec3f& position, const Vec3f& normal);
+
+// Shades a G-buffer with many lights. The frame is split into tiles, every tile builds the list
+// of the lights whose spheres touch the view space bounds of the tile between its nearest and
+// farthest depths, so a pixel pays only for the lights that can reach it. Tiles are shaded in
+// parallel.
+class TiledLighting
+{
+  public:
+    static const size_t TILE_SIZE = 16;
+
+    // 0 uses all hardware threads
+    void SetThreadCount(size_t count);
+
+    // Writes albedo * (ambient + lights) to the covered pixels of the target, the others are left
+    // as they are. screen_to_view maps (x, y, z, 1) of the depth buffer to view space.
+    void Shade(const GBuffer& gbuffer, const Canvas<float>& depth, const Mat4f& screen_to_view,
+               const std::vector<Light>& lights, const Vec3f& ambient, Image& target);
+
+    // number of lights of each tile in the last Shade, rows of tiles from the bottom
+    const std::vector<uint32_t>& TileLightCounts() const;
+    size_t TilesX() const;
+
+  private:
+    size_t thread_count_ = 0;
+    size_t tiles_x_ = 0;
+    std::vector<uint32_t> tile_light_counts_;
+};
+
+} // namespace sr
+
+#endif
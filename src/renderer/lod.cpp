@@ -0,0 +1,447 @@
+#include "lod.h"
+
+#include <algorithm>
+#include <cstring>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace sr
+{
+
+namespace
+{
+
+// symmetric 4x4 matrix stored as upper triangle: a00 a01 a02 a03 a11 a12 a13 a22 a23 a33
+struct Quadric
+{
+    double a[10] = {};
+
+    static Quadric FromPlane(const Vec3d& n, double d, double weight = 1.0)
+    {
+        Quadric q;
+        q.a[0] = n.x * n.x;
+        q.a[1] = n.x * n.y;
+        q.a[2] = n.x * n.z;
+        q.a[3] = n.x * d;
+        q.a[4] = n.y * n.y;
+        q.a[5] = n.y * n.z;
+        q.a[6] = n.y * d;
+        q.a[7] = n.z * n.z;
+        q.a[8] = n.z * d;
+        q.a[9] = d * d;
+        for (size_t i = 0; i < 10; ++i)
+            q.a[i] *= weight;
+        return q;
+    }
+
+    Quadric& operator+=(const Quadric& other)
+    {
+        for (size_t i = 0; i < 10; ++i)
+            a[i] += other.a[i];
+        return *this;
+    }
+
+    double Evaluate(const Vec3d& v) const
+    {
+        const double x = v.x, y = v.y, z = v.z;
+        return a[0] * x * x + 2 * a[1] * x * y + 2 * a[2] * x * z + 2 * a[3] * x + a[4] * y * y +
+               2 * a[5] * y * z + 2 * a[6] * y + a[7] * z * z + 2 * a[8] * z + a[9];
+    }
+
+    bool Optimal(Vec3d& result) const
+    {
+        const Mat3d m = {{a[0], a[1], a[2]}, {a[1], a[4], a[5]}, {a[2], a[5], a[7]}};
+        const double det = m.Determ();
+        if (std::fabs(det) < 1e-12)
+            return false;
+        result = Inverse(m) * Vec3d{-a[3], -a[6], -a[8]};
+        return true;
+    }
+};
+
+struct PositionHash
+{
+    size_t operator()(const Vec3f& v) const
+    {
+        uint32_t bits[3];
+        memcpy(bits, v.v, sizeof(bits));
+        return (size_t)(bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u);
+    }
+};
+
+uint64_t EdgeKey(uint32_t u, uint32_t v)
+{
+    if (u > v)
+        std::swap(u, v);
+    return (uint64_t(u) << 32) | v;
+}
+
+Vec3d ToDouble(const Vec3f& v)
+{
+    return Vec3d{v.x, v.y, v.z};
+}
+
+class Simplifier
+{
+  public:
+    explicit Simplifier(const Model& model);
+
+    void Simplify(size_t target_faces);
+    void Extract(Model& result) const;
+
+    size_t FaceCount() const
+    {
+        return face_count_;
+    }
+
+    float Error() const
+    {
+        return (float)std::sqrt(max_cost_);
+    }
+
+  private:
+    static constexpr double BOUNDARY_WEIGHT = 1000.0;
+    static constexpr double MIN_NORMAL_COS = 0.2;
+
+    struct SimplifierFace
+    {
+        uint32_t v[3];
+        Face source;
+        bool removed;
+    };
+
+    struct Candidate
+    {
+        double cost;
+        uint32_t u, v;
+        uint32_t stamp_u, stamp_v;
+        Vec3d target;
+
+        bool operator>(const Candidate& other) const
+        {
+            return cost > other.cost;
+        }
+    };
+
+    void AddFaceQuadrics();
+    void PushCandidate(uint32_t u, uint32_t v);
+    bool IsCollapseValid(const Candidate& candidate) const;
+    void Collapse(const Candidate& candidate);
+    Vec3d FaceNormal(const SimplifierFace& face, uint32_t replaced_u, uint32_t replaced_v,
+                     const Vec3d& target) const;
+
+    std::vector<Vec3d> positions_;
+    std::vector<Quadric> quadrics_;
+    std::vector<uint32_t> stamps_;
+    std::vector<bool> alive_;
+    std::vector<std::vector<uint32_t>> vertex_faces_;
+    std::vector<SimplifierFace> faces_;
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> heap_;
+    size_t face_count_;
+    double max_cost_;
+};
+
+Simplifier::Simplifier(const Model& model) : face_count_(0), max_cost_(0.0)
+{
+    std::unordered_map<Vec3f, uint32_t, PositionHash> welded;
+
+    faces_.reserve(model.faces.size());
+    for (const Face& face : model.faces)
+    {
+        SimplifierFace sface;
+        sface.source = face;
+        sface.removed = false;
+        for (size_t i = 0; i < 3; ++i)
+        {
+            const auto [iter, inserted] =
+                welded.emplace(face.v[i].coord, (uint32_t)(positions_.size()));
+            if (inserted)
+                positions_.push_back(ToDouble(face.v[i].coord));
+            sface.v[i] = iter->second;
+        }
+
+        if (sface.v[0] == sface.v[1] || sface.v[1] == sface.v[2] || sface.v[2] == sface.v[0])
+            continue;
+
+        faces_.push_back(sface);
+    }
+
+    face_count_ = faces_.size();
+    quadrics_.resize(positions_.size());
+    stamps_.assign(positions_.size(), 0);
+    alive_.assign(positions_.size(), true);
+    vertex_faces_.resize(positions_.size());
+
+    for (uint32_t f = 0; f < faces_.size(); ++f)
+        for (size_t i = 0; i < 3; ++i)
+            vertex_faces_[faces_[f].v[i]].push_back(f);
+
+    AddFaceQuadrics();
+
+    std::unordered_set<uint64_t> edges;
+    for (const SimplifierFace& face : faces_)
+    {
+        for (size_t i = 0; i < 3; ++i)
+        {
+            const uint32_t u = face.v[i];
+            const uint32_t v = face.v[(i + 1) % 3];
+            if (edges.insert(EdgeKey(u, v)).second)
+                PushCandidate(u, v);
+        }
+    }
+}
+
+void Simplifier::AddFaceQuadrics()
+{
+    std::unordered_map<uint64_t, uint32_t> edge_use;
+
+    for (const SimplifierFace& face : faces_)
+    {
+        const Vec3d& p0 = positions_[face.v[0]];
+        const Vec3d n = Normalize(Cross(positions_[face.v[1]] - p0, positions_[face.v[2]] - p0));
+        const Quadric q = Quadric::FromPlane(n, -(n * p0));
+        for (size_t i = 0; i < 3; ++i)
+        {
+            quadrics_[face.v[i]] += q;
+            edge_use[EdgeKey(face.v[i], face.v[(i + 1) % 3])] += 1;
+        }
+    }
+
+    // keep open borders in place with planes perpendicular to the boundary faces
+    for (const SimplifierFace& face : faces_)
+    {
+        const Vec3d& p0 = positions_[face.v[0]];
+        const Vec3d n = Normalize(Cross(positions_[face.v[1]] - p0, positions_[face.v[2]] - p0));
+        for (size_t i = 0; i < 3; ++i)
+        {
+            const uint32_t u = face.v[i];
+            const uint32_t v = face.v[(i + 1) % 3];
+            if (edge_use[EdgeKey(u, v)] != 1)
+                continue;
+
+            const Vec3d edge_normal = Normalize(Cross(positions_[v] - positions_[u], n));
+            const Quadric q =
+                Quadric::FromPlane(edge_normal, -(edge_normal * positions_[u]), BOUNDARY_WEIGHT);
+            quadrics_[u] += q;
+            quadrics_[v] += q;
+        }
+    }
+}
+
+void Simplifier::PushCandidate(uint32_t u, uint32_t v)
+{
+    Quadric q = quadrics_[u];
+    q += quadrics_[v];
+
+    Vec3d options[4] = {positions_[u], positions_[v], 0.5 * (positions_[u] + positions_[v])};
+    const size_t options_count = q.Optimal(options[3]) ? 4 : 3;
+
+    Candidate candidate;
+    candidate.cost = std::numeric_limits<double>::max();
+    for (size_t i = 0; i < options_count; ++i)
+    {
+        const double cost = q.Evaluate(options[i]);
+        if (cost < candidate.cost)
+        {
+            candidate.cost = cost;
+            candidate.target = options[i];
+        }
+    }
+
+    candidate.cost = std::max(candidate.cost, 0.0);
+    candidate.u = u;
+    candidate.v = v;
+    candidate.stamp_u = stamps_[u];
+    candidate.stamp_v = stamps_[v];
+    heap_.push(candidate);
+}
+
+Vec3d Simplifier::FaceNormal(const SimplifierFace& face, uint32_t replaced_u, uint32_t replaced_v,
+                             const Vec3d& target) const
+{
+    Vec3d p[3];
+    for (size_t i = 0; i < 3; ++i)
+    {
+        const bool replaced = face.v[i] == replaced_u || face.v[i] == replaced_v;
+        p[i] = replaced ? target : positions_[face.v[i]];
+    }
+    return Cross(p[1] - p[0], p[2] - p[0]);
+}
+
+bool Simplifier::IsCollapseValid(const Candidate& candidate) const
+{
+    const uint32_t ends[2] = {candidate.u, candidate.v};
+    for (uint32_t end : ends)
+    {
+        for (uint32_t f : vertex_faces_[end])
+        {
+            const SimplifierFace& face = faces_[f];
+            if (face.removed)
+                continue;
+
+            const bool has_u = face.v[0] == candidate.u || face.v[1] == candidate.u ||
+                               face.v[2] == candidate.u;
+            const bool has_v = face.v[0] == candidate.v || face.v[1] == candidate.v ||
+                               face.v[2] == candidate.v;
+            if (has_u && has_v)
+                continue; // this face degenerates and goes away
+
+            const Vec3d old_normal = Normalize(FaceNormal(face, end, end, positions_[end]));
+            const Vec3d new_normal =
+                Normalize(FaceNormal(face, candidate.u, candidate.v, candidate.target));
+            if (old_normal * new_normal < MIN_NORMAL_COS)
+                return false;
+        }
+    }
+    return true;
+}
+
+void Simplifier::Collapse(const Candidate& candidate)
+{
+    const uint32_t u = candidate.u;
+    const uint32_t v = candidate.v;
+
+    for (uint32_t f : vertex_faces_[v])
+    {
+        SimplifierFace& face = faces_[f];
+        if (face.removed)
+            continue;
+
+        if (face.v[0] == u || face.v[1] == u || face.v[2] == u)
+        {
+            face.removed = true;
+            --face_count_;
+            continue;
+        }
+
+        for (size_t i = 0; i < 3; ++i)
+            if (face.v[i] == v)
+                face.v[i] = u;
+        vertex_faces_[u].push_back(f);
+    }
+
+    std::vector<uint32_t>& u_faces = vertex_faces_[u];
+    u_faces.erase(std::remove_if(u_faces.begin(), u_faces.end(),
+                                 [this](uint32_t f) { return faces_[f].removed; }),
+                  u_faces.end());
+    vertex_faces_[v].clear();
+
+    positions_[u] = candidate.target;
+    quadrics_[u] += quadrics_[v];
+    alive_[v] = false;
+    ++stamps_[u];
+    ++stamps_[v];
+    max_cost_ = std::max(max_cost_, candidate.cost);
+
+    std::unordered_set<uint32_t> neighbours;
+    for (uint32_t f : u_faces)
+        for (size_t i = 0; i < 3; ++i)
+            if (faces_[f].v[i] != u)
+                neighbours.insert(faces_[f].v[i]);
+
+    for (uint32_t w : neighbours)
+        PushCandidate(u, w);
+}
+
+void Simplifier::Simplify(size_t target_faces)
+{
+    while (face_count_ > target_faces && !heap_.empty())
+    {
+        const Candidate candidate = heap_.top();
+        heap_.pop();
+
+        if (!alive_[candidate.u] || !alive_[candidate.v] ||
+            stamps_[candidate.u] != candidate.stamp_u || stamps_[candidate.v] != candidate.stamp_v)
+            continue;
+
+        if (!IsCollapseValid(candidate))
+            continue;
+
+        Collapse(candidate);
+    }
+}
+
+void Simplifier::Extract(Model& result) const
+{
+    result.faces.clear();
+    result.faces.reserve(face_count_);
+    for (const SimplifierFace& sface : faces_)
+    {
+        if (sface.removed)
+            continue;
+
+        Face face = sface.source;
+        for (size_t i = 0; i < 3; ++i)
+        {
+            const Vec3d& p = positions_[sface.v[i]];
+            face.v[i].coord = Vec3f{(float)p.x, (float)p.y, (float)p.z};
+        }
+        result.faces.push_back(face);
+    }
+}
+
+} // namespace
+
+float SimplifyModel(const Model& model, size_t target_faces, Model& result)
+{
+    Simplifier simplifier(model);
+    simplifier.Simplify(target_faces);
+    simplifier.Extract(result);
+    return simplifier.Error();
+}
+
+void BuildLods(const Model& model, LodChain& result, size_t max_levels, float reduction,
+               size_t min_faces)
+{
+    result.levels.clear();
+    result.levels.push_back(LodLevel{model, 0.0f});
+    BoundingSphere(model, result.center, result.radius);
+
+    Simplifier simplifier(model);
+    size_t faces = simplifier.FaceCount();
+
+    while (result.levels.size() < max_levels)
+    {
+        const size_t target_faces = (size_t)(faces * reduction);
+        if (target_faces < min_faces)
+            break;
+
+        simplifier.Simplify(target_faces);
+
+        // stop when the mesh can not be reduced any further (all collapses would flip faces)
+        if (simplifier.FaceCount() > faces - (faces - target_faces) / 2)
+            break;
+
+        faces = simplifier.FaceCount();
+        LodLevel level;
+        simplifier.Extract(level.model);
+        level.error = simplifier.Error();
+        result.levels.push_back(std::move(level));
+    }
+}
+
+void BoundingSphere(const Model& model, Vec3f& center, float& radius)
+{
+    center = Vec3f{0.0f, 0.0f, 0.0f};
+    radius = 0.0f;
+    if (model.faces.empty())
+        return;
+
+    Vec3f min = model.faces[0].v[0].coord;
+    Vec3f max = min;
+    for (const Face& face : model.faces)
+        for (size_t i = 0; i < 3; ++i)
+            for (size_t k = 0; k < 3; ++k)
+            {
+                min[k] = std::min(min[k], face.v[i].coord[k]);
+                max[k] = std::max(max[k], face.v[i].coord[k]);
+            }
+
+    center = 0.5f * (min + max);
+    for (const Face& face : model.faces)
+        for (size_t i = 0; i < 3; ++i)
+            radius = std::max(radius, (face.v[i].coord - center).Norm());
+}
+
+} // namespace sr
@@ -0,0 +1,38 @@
+#ifndef _LOD_H_
+#define _LOD_H_
+
+#include <vector>
+
+#include "geometry.h"
+#include "model.h"
+
+namespace sr
+{
+
+struct LodLevel
+{
+    Model model;
+    float error; // max geometric deviation from the source model, in model units
+};
+
+struct LodChain
+{
+    std::vector<LodLevel> levels; // levels[0] is the source model, each next one is coarser
+    Vec3f center;
+    float radius;
+};
+
+// Quadric error metric edge collapse (Garland & Heckbert). Vertices are welded by position, face
+// corners keep their own normals and texture coordinates. Returns the error of the result.
+float SimplifyModel(const Model& model, size_t target_faces, Model& result);
+
+// Builds progressively simplified levels until either max_levels is reached or a level would
+// have less than min_faces faces. Each level has about `reduction` times faces of the previous.
+void BuildLods(const Model& model, LodChain& result, size_t max_levels = 6,
+               float reduction = 0.5f, size_t min_faces = 64);
+
+void BoundingSphere(const Model& model, Vec3f& center, float& radius);
+
+} // namespace sr
+
+#endif
@@ -27,6 +27,28 @@ class MatrixStack
         SetMode(default_type_);
     }
 
+    // current_ points into the stack itself, so it is rebound instead of copied
+    MatrixStack(const MatrixStack& other)
+        : model_matrix_(other.model_matrix_), view_matrix_(other.view_matrix_),
+          projection_matrix_(other.projection_matrix_),
+          full_transform_matrix_(other.full_transform_matrix_),
+          is_full_transform_calculated_(other.is_full_transform_calculated_), saved_(other.saved_)
+    {
+        SetMode(other.current_type_);
+    }
+
+    MatrixStack& operator=(const MatrixStack& other)
+    {
+        model_matrix_ = other.model_matrix_;
+        view_matrix_ = other.view_matrix_;
+        projection_matrix_ = other.projection_matrix_;
+        full_transform_matrix_ = other.full_transform_matrix_;
+        is_full_transform_calculated_ = other.is_full_transform_calculated_;
+        saved_ = other.saved_;
+        SetMode(other.current_type_);
+        return *this;
+    }
+
     void SetMode(MatrixType type)
     {
         current_type_ = type;
@@ -86,6 +108,11 @@ class MatrixStack
         return model_matrix_;
     }
 
+    const Mat4f GetProjection() const
+    {
+        return projection_matrix_;
+    }
+
     void SetProjection(const Mat4f& mat)
     {
         projection_matrix_ = mat;
@@ -1,8 +1,39 @@
 #include "model.h"
 
+#include <cstring>
+#include <unordered_map>
+
+#include "../common/trace.h"
+
 namespace sr
 {
 
+namespace
+{
+// Vertices are compared bitwise, they are plain floats without padding
+struct VertexHash
+{
+    size_t operator()(const Vertex& vertex) const
+    {
+        uint32_t bits[sizeof(Vertex) / sizeof(uint32_t)];
+        memcpy(bits, &vertex, sizeof(bits));
+
+        size_t hash = 0;
+        for (uint32_t word : bits)
+            hash = hash * 0x9e3779b1u ^ word;
+        return hash;
+    }
+};
+
+struct VertexEqual
+{
+    bool operator()(const Vertex& lhs, const Vertex& rhs) const
+    {
+        return memcmp(&lhs, &rhs, sizeof(Vertex)) == 0;
+    }
+};
+} // namespace
+
 void Model::Normalize()
 {
     float maxNorm = 0;
@@ -26,6 +57,30 @@ void Model::Normalize()
             face->v[i].coord = face->v[i].coord * invMaxNorm;
 }
 
+void BuildIndexedModel(const Model& model, IndexedModel& result)
+{
+    TRACE_SCOPE("BuildIndexedModel");
+
+    result.vertices.clear();
+    result.indices.clear();
+    result.indices.reserve(3 * model.faces.size());
+
+    std::unordered_map<Vertex, uint32_t, VertexHash, VertexEqual> indices;
+    indices.reserve(model.faces.size());
+
+    for (const Face& face : model.faces)
+    {
+        for (const Vertex& vertex : face.v)
+        {
+            const auto [iter, inserted] =
+                indices.emplace(vertex, (uint32_t)(result.vertices.size()));
+            if (inserted)
+                result.vertices.push_back(vertex);
+            result.indices.push_back(iter->second);
+        }
+    }
+}
+
 std::vector<std::string> ObjReader::Split(std::string& string)
 {
     auto pred = [](char ch) {
@@ -225,6 +280,8 @@ void ObjReader::Clear()
 
 int ObjReader::ReadModel(const char* filename, Model& model)
 {
+    TRACE_SCOPE("ReadModel");
+
     std::ifstream file(filename);
     if (!file.is_open())
     {
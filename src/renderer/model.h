@@ -25,6 +25,15 @@ struct Model
     void Normalize();
 };
 
+// Faces as triples of indices into vertices, equal corners of faces share one vertex
+struct IndexedModel
+{
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+};
+
+void BuildIndexedModel(const Model& model, IndexedModel& result);
+
 class ObjReader
 {
     std::vector<Vec3f> verts_;
@@ -0,0 +1,61 @@
+#ifndef _PIPELINE_STATS_H_
+#define _PIPELINE_STATS_H_
+
+#include <stdint.h>
+
+namespace sr
+{
+
+// Counters of the work done by the pipeline, like pipeline statistics queries of a GPU. Every
+// renderer counts into its own stats, stats of renderers on different threads add up with +=.
+struct PipelineStats
+{
+    uint64_t triangles_submitted = 0;
+    // runs of the vertex stage, three per triangle unless vertices are shared
+    uint64_t vertices_shaded = 0;
+    uint64_t triangles_culled_back_face = 0;
+    uint64_t triangles_culled_zero_area = 0;
+    uint64_t triangles_culled_off_screen = 0;
+    // completely outside of the depth range, e.g. behind the near plane
+    uint64_t triangles_culled_depth = 0;
+    // partly outside of the screen, the rest is rasterized
+    uint64_t triangles_clipped = 0;
+    uint64_t triangles_rasterized = 0;
+
+    // inside of a rasterized triangle and the screen
+    uint64_t pixels_covered = 0;
+    // inside of the depth range, compared with the depth buffer
+    uint64_t pixels_depth_tested = 0;
+    uint64_t pixels_depth_passed = 0;
+    uint64_t pixels_shaded = 0;
+    // not discarded by the shader
+    uint64_t pixels_written = 0;
+
+    uint64_t TrianglesCulled() const
+    {
+        return triangles_culled_back_face + triangles_culled_zero_area +
+               triangles_culled_off_screen + triangles_culled_depth;
+    }
+
+    PipelineStats& operator+=(const PipelineStats& other)
+    {
+        triangles_submitted += other.triangles_submitted;
+        vertices_shaded += other.vertices_shaded;
+        triangles_culled_back_face += other.triangles_culled_back_face;
+        triangles_culled_zero_area += other.triangles_culled_zero_area;
+        triangles_culled_off_screen += other.triangles_culled_off_screen;
+        triangles_culled_depth += other.triangles_culled_depth;
+        triangles_clipped += other.triangles_clipped;
+        triangles_rasterized += other.triangles_rasterized;
+        pixels_covered += other.pixels_covered;
+        pixels_depth_tested += other.pixels_depth_tested;
+        pixels_depth_passed += other.pixels_depth_passed;
+        pixels_shaded += other.pixels_shaded;
+        pixels_written += other.pixels_written;
+        return *this;
+    }
+};
+
+} // namespace sr
+
+#endif
@@ -2,8 +2,13 @@
 #include "shader.h"
 
 #include <algorithm>
+#include <cmath>
 #include <tuple>
 
+#include "../common/blit.h"
+#include "../common/simd.h"
+#include "../common/trace.h"
+
 namespace sr
 {
 
@@ -56,124 +61,556 @@ static Rect<T> BoundingBox(Vec<n, T> p1, Vec<n, T> p2, Vec<n, T> p3)
     return rect;
 }
 
-Vec3f DoBarPerspectiveCorrection(const Vec3f& bar, const Vec3f& corr)
+// Where and how shaded pixels are written
+struct PixelOutput
+{
+    Image& canvas;
+    Canvas<float>& z_buffer;
+    const BlendState& blend;
+    float far_z;
+    // set for the G-buffer pass, the canvas is then the albedo and the blending is ignored
+    Canvas<uint32_t>* normals = nullptr;
+};
+
+void WritePixel(const PixelOutput& out, int x, int y, float z, Color color)
 {
-    const Vec3f corrected_bar = Vec3f{bar[0] * corr[0], bar[1] * corr[1], bar[2] * corr[2]};
-    return corrected_bar / corrected_bar.Sum();
+    uint32_t& dst = out.canvas.At(x, y);
+    switch (out.blend.mode)
+    {
+    case BlendMode::OPAQUE:
+        out.z_buffer.At(x, y) = z;
+        dst = color;
+        break;
+    case BlendMode::ALPHA:
+        dst = BlendAlpha(color, dst);
+        break;
+    case BlendMode::ADDITIVE:
+        dst = BlendAdditive(color, dst);
+        break;
+    case BlendMode::MULTIPLY:
+        dst = BlendMultiply(color, dst);
+        break;
+    case BlendMode::WEIGHTED_OIT:
+        out.blend.oit->Accumulate(x, y, z / out.far_z, color);
+        break;
+    }
 }
 
-void PutShaderedPixel(Image& canvas, Canvas<float>& z_buffer, int x, int y, float z, Vec3f bar,
-                      Shader& shader)
+// Vertex positions are snapped to a grid of 1/256 pixel and coverage is decided by integer edge
+// functions with the top-left fill rule, so triangles sharing an edge cover every pixel exactly
+// once and the result does not depend on the order in which pixels or triangles are visited.
+const int SUBPIXEL_BITS = 8;
+const int64_t SUBPIXEL_ONE = 1 << SUBPIXEL_BITS;
+const int64_t SUBPIXEL_HALF = SUBPIXEL_ONE / 2;
+// Snapped coordinates are clamped to this many pixels, so products of their differences fit
+// into 64 bits
+const float GUARD_BAND = (float)(1 << 21);
+
+int64_t Snap(float value)
 {
-    Color color;
+    const float clamped = std::clamp(value, -GUARD_BAND, GUARD_BAND);
+    return (int64_t)(std::floor(clamped * SUBPIXEL_ONE + 0.5f));
+}
+
+// Edge from a to b: E(p) = (b - a) x (p - a), positive on the left of the edge, i.e. inside of a
+// counterclockwise triangle, and stepped by constant increments along x and y
+struct Edge
+{
+    int64_t step_x;
+    int64_t step_y;
+    int64_t bias; // 0 for top and left edges which own the pixels centered on them, -1 otherwise
 
-    if (z >= 0 && z < z_buffer.At(x, y) && shader.pixel(bar, color))
+    Edge() = default;
+    Edge(int64_t ax, int64_t ay, int64_t bx, int64_t by)
     {
-        z_buffer.SetPixel(x, y, z);
-        canvas.SetPixel(x, y, color);
+        const int64_t dx = bx - ax;
+        const int64_t dy = by - ay;
+        step_x = -dy * SUBPIXEL_ONE;
+        step_y = dx * SUBPIXEL_ONE;
+        // with y going up the inside is to the right of a left edge and below a top edge
+        const bool is_top_left = dy < 0 || (dy == 0 && dx < 0);
+        bias = is_top_left ? 0 : -1;
+    }
+
+    static int64_t Evaluate(int64_t ax, int64_t ay, int64_t bx, int64_t by, int64_t px,
+                            int64_t py)
+    {
+        return (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+    }
+};
+
+// Screen-space plane of a value which is linear over the triangle
+struct Plane
+{
+    float origin; // at the center of the first pixel of the clipped bounding box
+    float dx;
+    float dy;
+};
+
+// values are given at the vertices in the order of the edges opposite to them
+Plane SetupPlane(const float values[3], const Edge edges[3], const int64_t origin[3],
+                 double inv_area)
+{
+    double at_origin = 0.0, dx = 0.0, dy = 0.0;
+    for (size_t i = 0; i < 3; ++i)
+    {
+        at_origin += values[i] * (double)(origin[i]);
+        dx += values[i] * (double)(edges[i].step_x);
+        dy += values[i] * (double)(edges[i].step_y);
     }
+    return {(float)(at_origin * inv_area), (float)(dx * inv_area), (float)(dy * inv_area)};
 }
 
-void RasterizeHorizontalDegenerateTriangle(Image& canvas, Canvas<float>& z_buffer, Vec4f screen1,
-                                           Vec4f screen2, Vec4f screen3, Vec3f bar_corr, Vertex v1,
-                                           Vertex v2, Vertex v3, Shader& shader)
+// Depth is linear in screen space, varyings are not, but their values divided by w are. The
+// perspective corrected barycentric coordinates c1 = (b1 / w) / (1 / w) and c2 take one
+// reciprocal per pixel, and each varying is then base + c1 * delta1 + c2 * delta2.
+struct TriangleSetup
 {
-    const float width = (float)canvas.width;
-    const float height = (float)canvas.height;
+    Plane z;
+    Plane inv_w;
+    Plane bar1_w;
+    Plane bar2_w;
+
+    // vertices 1 and 2 are swapped for a clockwise triangle
+    Varyings base;
+    Varyings delta1;
+    Varyings delta2;
+    size_t varying_count; // rounded up to a multiple of 4
+};
+
+// Depth is evaluated per pixel as row_z + dz * (x - start_x) by both the shaded and the depth-only
+// paths, so a depth prepass leaves exactly the values the shading pass computes
+struct Interpolants
+{
+    float z;
+    float inv_w;
+    float bar1_w;
+    float bar2_w;
+
+    Interpolants(const TriangleSetup& setup, float x, float y)
+        : z(setup.z.origin + setup.z.dx * x + setup.z.dy * y),
+          inv_w(setup.inv_w.origin + setup.inv_w.dx * x + setup.inv_w.dy * y),
+          bar1_w(setup.bar1_w.origin + setup.bar1_w.dx * x + setup.bar1_w.dy * y),
+          bar2_w(setup.bar2_w.origin + setup.bar2_w.dx * x + setup.bar2_w.dy * y)
+    {}
+
+    void StepX(const TriangleSetup& setup)
+    {
+        inv_w += setup.inv_w.dx;
+        bar1_w += setup.bar1_w.dx;
+        bar2_w += setup.bar2_w.dx;
+    }
+};
+
+// out = base + c1 * delta1 + c2 * delta2, four varyings at a time
+void Combine(const Varyings& base, const Varyings& delta1, const Varyings& delta2, float c1,
+             float c2, size_t count, Varyings& out)
+{
+#ifdef SR_SSE2
+    const __m128 c1s = _mm_set1_ps(c1);
+    const __m128 c2s = _mm_set1_ps(c2);
+    for (size_t i = 0; i < count; i += 4)
+    {
+        const __m128 sum = _mm_add_ps(_mm_load_ps(base.v + i),
+                                      _mm_add_ps(_mm_mul_ps(c1s, _mm_load_ps(delta1.v + i)),
+                                                 _mm_mul_ps(c2s, _mm_load_ps(delta2.v + i))));
+        _mm_store_ps(out.v + i, sum);
+    }
+#else
+    for (size_t i = 0; i < count; ++i)
+        out.v[i] = base.v[i] + (c1 * delta1.v[i] + c2 * delta2.v[i]);
+#endif
+}
+
+// Derivatives of c = (b / w) * w are (d(b / w) - c * d(1 / w)) * w
+void UpdateDerivatives(const TriangleSetup& setup, float w, float c1, float c2,
+                       ShaderContext& context)
+{
+    const float dc1_dx = (setup.bar1_w.dx - c1 * setup.inv_w.dx) * w;
+    const float dc2_dx = (setup.bar2_w.dx - c2 * setup.inv_w.dx) * w;
+    const float dc1_dy = (setup.bar1_w.dy - c1 * setup.inv_w.dy) * w;
+    const float dc2_dy = (setup.bar2_w.dy - c2 * setup.inv_w.dy) * w;
+
+    static const Varyings zero = {};
+    Combine(zero, setup.delta1, setup.delta2, dc1_dx, dc2_dx, setup.varying_count, context.dx);
+    Combine(zero, setup.delta1, setup.delta2, dc1_dy, dc2_dy, setup.varying_count, context.dy);
+}
+
+void ShadePixel(const PixelOutput& out, int x, int y, const TriangleSetup& setup,
+                const Interpolants& values, const Shader& shader, ShaderContext& context,
+                PipelineStats& stats)
+{
+    ++stats.pixels_covered;
+    const float z = values.z;
+    if (z < 0)
+        return;
+
+    ++stats.pixels_depth_tested;
+    const float old_z = out.z_buffer.At(x, y);
+    if (z > old_z || (z == old_z && out.blend.depth_test == DepthTest::LESS))
+        return;
+
+    ++stats.pixels_depth_passed;
+
+    const float w = 1.0f / values.inv_w;
+    const float c1 = values.bar1_w * w;
+    const float c2 = values.bar2_w * w;
 
-    const Vec3f zs = {screen1.z, screen2.z, screen3.z};
+    Varyings varyings;
+    Combine(setup.base, setup.delta1, setup.delta2, c1, c2, setup.varying_count, varyings);
+    if (shader.needs_derivatives)
+        UpdateDerivatives(setup, w, c1, c2, context);
 
-    Vec3f bar;
-    VecView bar_view(bar);
+    ++stats.pixels_shaded;
+    if (out.normals != nullptr)
+    {
+        Color albedo;
+        Vec3f normal;
+        if (!shader.surface(varyings, context, albedo, normal))
+            return;
+
+        ++stats.pixels_written;
+        out.z_buffer.At(x, y) = z;
+        out.canvas.At(x, y) = albedo;
+        out.normals->At(x, y) = EncodeNormal(normal);
+        return;
+    }
 
-    const int y = Round(screen1.y);
+    Color color;
+    if (!shader.pixel(varyings, context, color))
+        return;
 
-    int x1 = Round(screen1.x);
-    int x2 = Round(screen2.x);
-    int x3 = Round(screen3.x);
+    ++stats.pixels_written;
+    WritePixel(out, x, y, z, color);
+}
 
-    if (x1 > x2)
+// Snapped triangle in counterclockwise order with its edge functions at the center of the first
+// pixel of the bounding box clipped to the canvas
+struct EdgeSetup
+{
+    int64_t xs[3];
+    int64_t ys[3];
+    float zs[3];
+    float inv_ws[3];
+    bool swapped; // vertices 1 and 2, the triangle was clockwise
+    int64_t area;
+
+    // the edge opposite to a vertex gives its barycentric coordinate
+    Edge edges[3];
+    int64_t row[3];
+
+    int64_t start_x;
+    int64_t end_x;
+    int64_t start_y;
+    int64_t end_y;
+};
+
+// false if the triangle is culled
+bool SetupEdges(Vec4f screen1, Vec4f screen2, Vec4f screen3, int64_t width, int64_t height,
+                float far_z, EdgeSetup& setup, PipelineStats& stats)
+{
+    int64_t* xs = setup.xs;
+    int64_t* ys = setup.ys;
+    float* zs = setup.zs;
+    float* inv_ws = setup.inv_ws;
+
+    xs[0] = Snap(screen1.x), xs[1] = Snap(screen2.x), xs[2] = Snap(screen3.x);
+    ys[0] = Snap(screen1.y), ys[1] = Snap(screen2.y), ys[2] = Snap(screen3.y);
+    zs[0] = screen1.z, zs[1] = screen2.z, zs[2] = screen3.z;
+    inv_ws[0] = 1.0f / screen1.w, inv_ws[1] = 1.0f / screen2.w, inv_ws[2] = 1.0f / screen3.w;
+
+    // pixel whose center is the nearest to the lower left and to the upper right corners
+    const auto [min_x, max_x] = MinMax(xs[0], xs[1], xs[2]);
+    const auto [min_y, max_y] = MinMax(ys[0], ys[1], ys[2]);
+    const int64_t first_x = (min_x - SUBPIXEL_HALF + SUBPIXEL_ONE - 1) >> SUBPIXEL_BITS;
+    const int64_t last_x = (max_x - SUBPIXEL_HALF) >> SUBPIXEL_BITS;
+    const int64_t first_y = (min_y - SUBPIXEL_HALF + SUBPIXEL_ONE - 1) >> SUBPIXEL_BITS;
+    const int64_t last_y = (max_y - SUBPIXEL_HALF) >> SUBPIXEL_BITS;
+
+    if (last_x < 0 || first_x >= width || last_y < 0 || first_y >= height)
     {
-        std::swap(x1, x2);
-        std::swap(bar_view[0], bar_view[1]);
+        ++stats.triangles_culled_off_screen;
+        return false;
     }
-    if (x2 > x3)
+
+    const auto [min_z, max_z] = MinMax(zs[0], zs[1], zs[2]);
+    if (max_z < 0 || min_z >= far_z)
     {
-        std::swap(x2, x3);
-        std::swap(bar_view[1], bar_view[2]);
+        ++stats.triangles_culled_depth;
+        return false;
     }
-    if (x1 > x2)
+
+    setup.area = Edge::Evaluate(xs[0], ys[0], xs[1], ys[1], xs[2], ys[2]);
+    if (setup.area == 0)
     {
-        std::swap(x1, x2);
-        std::swap(bar_view[0], bar_view[1]);
+        ++stats.triangles_culled_zero_area;
+        return false;
     }
 
-    if (x1 == x3)
+    // edges are set up for a counterclockwise order
+    setup.swapped = setup.area < 0;
+    if (setup.swapped)
     {
-        bar_view = Vec3f{1.0f, 0.0f, 0.0f};
-        PutShaderedPixel(canvas, z_buffer, x1, y, zs * bar, bar, shader);
-        bar_view = Vec3f{0.0f, 1.0f, 0.0f};
-        PutShaderedPixel(canvas, z_buffer, x1, y, zs * bar, bar, shader);
-        bar_view = Vec3f{0.0f, 0.0f, 1.0f};
-        PutShaderedPixel(canvas, z_buffer, x1, y, zs * bar, bar, shader);
-        return;
+        std::swap(xs[1], xs[2]);
+        std::swap(ys[1], ys[2]);
+        std::swap(zs[1], zs[2]);
+        std::swap(inv_ws[1], inv_ws[2]);
+        setup.area = -setup.area;
     }
 
-    const float invLength = 1.0f / (x3 - x1);
-    const float invRightLength = x3 - x2 != 0 ? 1.0f / (x3 - x2) : 0.0f;
-    const float invLeftLength = x2 - x1 != 0 ? 1.0f / (x2 - x1) : 0.0f;
+    if (first_x < 0 || last_x >= width || first_y < 0 || last_y >= height)
+        ++stats.triangles_clipped;
+    ++stats.triangles_rasterized;
+
+    setup.edges[0] = Edge(xs[1], ys[1], xs[2], ys[2]);
+    setup.edges[1] = Edge(xs[2], ys[2], xs[0], ys[0]);
+    setup.edges[2] = Edge(xs[0], ys[0], xs[1], ys[1]);
+
+    setup.start_x = std::max<int64_t>(first_x, 0);
+    setup.end_x = std::min(last_x, width - 1);
+    setup.start_y = std::max<int64_t>(first_y, 0);
+    setup.end_y = std::min(last_y, height - 1);
+
+    const int64_t px = setup.start_x * SUBPIXEL_ONE + SUBPIXEL_HALF;
+    const int64_t py = setup.start_y * SUBPIXEL_ONE + SUBPIXEL_HALF;
+    setup.row[0] = Edge::Evaluate(xs[1], ys[1], xs[2], ys[2], px, py);
+    setup.row[1] = Edge::Evaluate(xs[2], ys[2], xs[0], ys[0], px, py);
+    setup.row[2] = Edge::Evaluate(xs[0], ys[0], xs[1], ys[1], px, py);
+    return true;
+}
+
+void RasterizeTriangleImpl(const PixelOutput& out, Vec4f screen1, Vec4f screen2, Vec4f screen3,
+                           const Varyings& v1, const Varyings& v2, const Varyings& v3,
+                           const Shader& shader, PipelineStats& stats)
+{
+    EdgeSetup edge_setup;
+    if (!SetupEdges(screen1, screen2, screen3, (int64_t)(out.canvas.width),
+                    (int64_t)(out.canvas.height), out.far_z, edge_setup, stats))
+        return;
+
+    const Edge* edges = edge_setup.edges;
+    int64_t* row = edge_setup.row;
+    const int64_t start_x = edge_setup.start_x;
+    const int64_t end_x = edge_setup.end_x;
+    const int64_t start_y = edge_setup.start_y;
+    const int64_t end_y = edge_setup.end_y;
+
+    const Varyings* varyings[3] = {&v1, &v2, &v3};
+    if (edge_setup.swapped)
+        std::swap(varyings[1], varyings[2]);
+
+    TriangleSetup setup;
+    const double inv_area = 1.0 / (double)(edge_setup.area);
+    const float* inv_ws = edge_setup.inv_ws;
+    const float bar1_ws[3] = {0.0f, inv_ws[1], 0.0f};
+    const float bar2_ws[3] = {0.0f, 0.0f, inv_ws[2]};
+    setup.z = SetupPlane(edge_setup.zs, edges, row, inv_area);
+    setup.inv_w = SetupPlane(inv_ws, edges, row, inv_area);
+    setup.bar1_w = SetupPlane(bar1_ws, edges, row, inv_area);
+    setup.bar2_w = SetupPlane(bar2_ws, edges, row, inv_area);
+
+    setup.varying_count = (shader.varying_count + 3) & ~(size_t)(3);
+    for (size_t i = 0; i < setup.varying_count; ++i)
+    {
+        setup.base.v[i] = varyings[0]->v[i];
+        setup.delta1.v[i] = varyings[1]->v[i] - varyings[0]->v[i];
+        setup.delta2.v[i] = varyings[2]->v[i] - varyings[0]->v[i];
+    }
 
-    for (int x = x1; x <= x3; ++x)
+    ShaderContext context;
+    for (int64_t y = start_y; y <= end_y; ++y)
     {
-        const bool rightSegment = x >= x2;
+        // rows start from the plane, so the stepping error does not build up across rows
+        Interpolants values(setup, 0.0f, (float)(y - start_y));
+        const float row_z = values.z;
+        int64_t w[3] = {row[0], row[1], row[2]};
 
-        const float t = (x - x1) * invLength;
-        const float u = rightSegment ? (x - x2) * invRightLength : (x - x1) * invLeftLength;
+        for (int64_t x = start_x; x <= end_x; ++x)
+        {
+            if ((w[0] + edges[0].bias | w[1] + edges[1].bias | w[2] + edges[2].bias) >= 0)
+            {
+                values.z = row_z + setup.z.dx * (float)(x - start_x);
+                ShadePixel(out, (int)(x), (int)(y), setup, values, shader, context, stats);
+            }
 
-        // first side
-        bar_view = Vec3f{(1.0f - t), 0.0f, t};
-        Vec3f corrected_bar = DoBarPerspectiveCorrection(bar, bar_corr);
-        PutShaderedPixel(canvas, z_buffer, x, y, zs * corrected_bar, corrected_bar, shader);
+            for (size_t i = 0; i < 3; ++i)
+                w[i] += edges[i].step_x;
+            values.StepX(setup);
+        }
 
-        // second side
-        if (rightSegment)
-            bar_view = Vec3f{0.0f, (1.0f - u), u};
-        else
-            bar_view = Vec3f{(1.0f - u), u, 0.0f};
+        for (size_t i = 0; i < 3; ++i)
+            row[i] += edges[i].step_y;
+    }
+}
 
-        corrected_bar = DoBarPerspectiveCorrection(bar, bar_corr);
-        PutShaderedPixel(canvas, z_buffer, x, y, zs * corrected_bar, corrected_bar, shader);
+// Offsets from start_x of the first and the last pixels covered in a row. Every edge function is
+// linear in x, so the covered pixels form one span which is found without testing them.
+bool RowSpan(const Edge edges[3], const int64_t row[3], int64_t length, int64_t& first,
+             int64_t& last)
+{
+    first = 0;
+    last = length - 1;
+    for (size_t i = 0; i < 3; ++i)
+    {
+        const int64_t value = row[i] + edges[i].bias;
+        const int64_t step = edges[i].step_x;
+        if (step > 0)
+        {
+            if (value < 0)
+                first = std::max(first, (-value + step - 1) / step);
+        }
+        else if (value < 0)
+        {
+            return false;
+        }
+        else if (step < 0)
+        {
+            last = std::min(last, value / -step);
+        }
     }
+    return first <= last;
 }
 
-} // namespace
+// Pixels passed with z >= 0 and below the depth buffer, in the order of the bits of a mask
+const uint8_t BIT_COUNTS[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
 
-void RasterizeRectangle(Image& canvas, int32_t x1, int32_t y1, int32_t x2, int32_t y2, Color color)
+// Writes the nearer depth of the span from x0 to x1 inclusive, z = row_z + dz * (x - start_x)
+void DepthSpan(float* depth, int64_t x0, int64_t x1, int64_t start_x, float row_z, float dz,
+               PipelineStats& stats)
 {
-    int inc = x2 > x1 ? 1 : -1;
-    for (int i = x1; i != x2; i += inc)
+    int64_t x = x0;
+    uint64_t tested = 0, passed = 0;
+#ifdef SR_SSE2
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 row_zs = _mm_set1_ps(row_z);
+    const __m128 dzs = _mm_set1_ps(dz);
+    const __m128 four = _mm_set1_ps(4.0f);
+    // offsets are integers, exact in floats, so the depth is the same as in the scalar code
+    const float offset = (float)(x0 - start_x);
+    __m128 offsets = _mm_add_ps(_mm_set1_ps(offset), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+    for (; x + 3 <= x1; x += 4)
     {
-        canvas.SetPixel(i, y1, color);
-        canvas.SetPixel(i, y2, color);
+        const __m128 z = _mm_add_ps(row_zs, _mm_mul_ps(dzs, offsets));
+        const __m128 old_z = _mm_loadu_ps(depth + x);
+        const __m128 in_front = _mm_cmpge_ps(z, zero);
+        const __m128 pass = _mm_and_ps(in_front, _mm_cmplt_ps(z, old_z));
+        _mm_storeu_ps(depth + x, _mm_or_ps(_mm_and_ps(pass, z), _mm_andnot_ps(pass, old_z)));
+
+        tested += BIT_COUNTS[_mm_movemask_ps(in_front)];
+        passed += BIT_COUNTS[_mm_movemask_ps(pass)];
+        offsets = _mm_add_ps(offsets, four);
     }
+#endif
+    for (; x <= x1; ++x)
+    {
+        const float z = row_z + dz * (float)(x - start_x);
+        if (z < 0)
+            continue;
+        ++tested;
+        if (z < depth[x])
+        {
+            depth[x] = z;
+            ++passed;
+        }
+    }
+
+    stats.pixels_covered += (uint64_t)(x1 - x0 + 1);
+    stats.pixels_depth_tested += tested;
+    stats.pixels_depth_passed += passed;
+    stats.pixels_written += passed;
+}
+
+void RasterizeDepthImpl(Canvas<float>& z_buffer, float far_z, Vec4f screen1, Vec4f screen2,
+                        Vec4f screen3, PipelineStats& stats)
+{
+    EdgeSetup edge_setup;
+    if (!SetupEdges(screen1, screen2, screen3, (int64_t)(z_buffer.width),
+                    (int64_t)(z_buffer.height), far_z, edge_setup, stats))
+        return;
+
+    const Edge* edges = edge_setup.edges;
+    int64_t* row = edge_setup.row;
+    const double inv_area = 1.0 / (double)(edge_setup.area);
+    const Plane z = SetupPlane(edge_setup.zs, edges, row, inv_area);
+    const int64_t length = edge_setup.end_x - edge_setup.start_x + 1;
 
-    inc = y2 > y1 ? 1 : -1;
-    for (int i = y1; i != y2; i += inc)
+    for (int64_t y = edge_setup.start_y; y <= edge_setup.end_y; ++y)
     {
-        canvas.SetPixel(x1, i, color);
-        canvas.SetPixel(x2, i, color);
+        // the same row start as Interpolants
+        const float row_z = z.origin + z.dx * 0.0f + z.dy * (float)(y - edge_setup.start_y);
+
+        int64_t first, last;
+        if (RowSpan(edges, row, length, first, last))
+        {
+            float* depth = &z_buffer.At(0, (size_t)(y));
+            DepthSpan(depth, edge_setup.start_x + first, edge_setup.start_x + last,
+                      edge_setup.start_x, row_z, z.dx, stats);
+        }
+
+        for (size_t i = 0; i < 3; ++i)
+            row[i] += edges[i].step_y;
     }
 }
 
-void RasterizeSolidRect(Image& canvas, int32_t x1, int32_t y1, int32_t x2, int32_t y2, Color color)
+// Steps along the major axis with pointers into the canvas and the depth buffer, which have the
+// same layout: rows from top to bottom, so going up in y goes back in memory
+template <bool depth_test>
+void DrawClippedLine(Image& canvas, const Canvas<float>* z_buffer, Vec2i p1, Vec2i p2, float z1,
+                     float z2, Color color, float depth_bias)
 {
-    int xinc = x2 > x1 ? 1 : -1;
-    int yinc = y2 > y1 ? 1 : -1;
-    for (int y = y1; y != y2; y += yinc)
-        for (int x = x1; x != x2; x += xinc)
+    const int dx = abs(p2.x - p1.x);
+    const int dy = abs(p2.y - p1.y);
+    const ptrdiff_t step_x = p2.x >= p1.x ? 1 : -1;
+    const ptrdiff_t step_y = p2.y >= p1.y ? -(ptrdiff_t)(canvas.width) : canvas.width;
+
+    const bool x_major = dx >= dy;
+    const int major = x_major ? dx : dy;
+    const int minor = x_major ? dy : dx;
+    const ptrdiff_t major_step = x_major ? step_x : step_y;
+    const ptrdiff_t minor_step = x_major ? step_y : step_x;
+
+    const ptrdiff_t offset = &canvas.At(p1.x, p1.y) - canvas.Data();
+    uint32_t* pixel = canvas.Data() + offset;
+    const float* depth = depth_test ? z_buffer->Data() + offset : nullptr;
+
+    float z = z1 - depth_bias;
+    const float dz = major > 0 ? (z2 - z1) / major : 0.0f;
+
+    int err = 2 * minor - major;
+    for (int i = 0; i <= major; ++i)
+    {
+        if (!depth_test || z < *depth)
+            *pixel = color;
+
+        ptrdiff_t step = major_step;
+        if (err > 0)
         {
-            canvas.SetPixel(x, y, color);
+            step += minor_step;
+            err -= 2 * major;
         }
+        err += 2 * minor;
+
+        pixel += step;
+        if (depth_test)
+        {
+            depth += step;
+            z += dz;
+        }
+    }
+}
+} // namespace
+
+void RasterizeRectangle(Image& canvas, int32_t x1, int32_t y1, int32_t x2, int32_t y2, Color color)
+{
+    FillRect(canvas, x1, y1, x2, y1 + 1, color);
+    FillRect(canvas, x1, y2, x2, y2 + 1, color);
+    FillRect(canvas, x1, y1, x1 + 1, y2, color);
+    FillRect(canvas, x2, y1, x2 + 1, y2, color);
+}
+
+void RasterizeSolidRect(Image& canvas, int32_t x1, int32_t y1, int32_t x2, int32_t y2, Color color)
+{
+    FillRect(canvas, x1, y1, x2, y2, color);
 }
 
 void RasterizeLine(Image& canvas, Vec2i p1, Vec2i p2, Color color)
@@ -211,6 +648,19 @@ void RasterizeLine(Image& canvas, Vec2i p1, Vec2i p2, Color color)
     }
 }
 
+void RasterizeClippedLine(Image& canvas, Vec2i p1, Vec2i p2, Color color)
+{
+    DrawClippedLine<false>(canvas, nullptr, p1, p2, 0.0f, 0.0f, color, 0.0f);
+}
+
+void RasterizeClippedLine(Image& canvas, const Canvas<float>& z_buffer, Vec3f p1, Vec3f p2,
+                          Color color, float depth_bias)
+{
+    const Vec2i i1 = {Round(p1.x), Round(p1.y)};
+    const Vec2i i2 = {Round(p2.x), Round(p2.y)};
+    DrawClippedLine<true>(canvas, &z_buffer, i1, i2, p1.z, p2.z, color, depth_bias);
+}
+
 void PutPixel(Image& canvas, Canvas<float>& z_buffer, int x, int y, float z, Color color)
 {
     if (z >= 0 && z < z_buffer.At(x, y))
@@ -221,110 +671,45 @@ void PutPixel(Image& canvas, Canvas<float>& z_buffer, int x, int y, float z, Col
 }
 
 void RasterizeTriangle(Image& canvas, Canvas<float>& z_buffer, float far_z, Vec4f screen1,
-                       Vec4f screen2, Vec4f screen3, const Vertex& v1, const Vertex& v2,
-                       const Vertex& v3, Shader& shader)
+                       Vec4f screen2, Vec4f screen3, const Varyings& v1, const Varyings& v2,
+                       const Varyings& v3, const Shader& shader, const BlendState& blend,
+                       PipelineStats& stats)
 {
-    const float width = (float)canvas.width;
-    const float height = (float)canvas.height;
-
-    const Vec3f zs = {screen1.z, screen2.z, screen3.z};
-    const Vec3f bar_corr = {1.0f / screen1.w, 1.0f / screen2.w, 1.0f / screen3.w};
-
-    Vec3f bar;
-    VecView bar_view(bar);
-
-    Vec2i i1 = {Round(screen1.x), Round(screen1.y)};
-    Vec2i i2 = {Round(screen2.x), Round(screen2.y)};
-    Vec2i i3 = {Round(screen3.x), Round(screen3.y)};
-
-    if (i1.y > i2.y)
-    {
-        std::swap(i1, i2);
-        std::swap(bar_view[0], bar_view[1]);
-    }
-    if (i2.y > i3.y)
-    {
-        std::swap(i2, i3);
-        std::swap(bar_view[1], bar_view[2]);
-    }
-    if (i1.y > i2.y)
-    {
-        std::swap(i1, i2);
-        std::swap(bar_view[0], bar_view[1]);
-    }
+    TRACE_SCOPE("RasterizeTriangle");
 
-    if (i1.y >= height || i3.y < 0)
-        return;
+    const PixelOutput out = {canvas, z_buffer, blend, far_z};
 
-    const auto [min_x, max_x] = MinMax(i1.x, i2.x, i3.x);
-    if (max_x < 0 || min_x >= width)
-        return;
+    // counting into a local copy keeps the counters of the pixel loops in registers
+    PipelineStats counters;
+    RasterizeTriangleImpl(out, screen1, screen2, screen3, v1, v2, v3, shader, counters);
 
-    const auto [min_z, max_z] = MinMax(screen1.z, screen2.z, screen3.z);
-    if (max_z < 0 || min_z >= far_z)
-        return;
-
-    if (i1.y == i3.y)
-    {
-        RasterizeHorizontalDegenerateTriangle(canvas, z_buffer, screen1, screen2, screen3, bar_corr,
-                                              v1, v2, v3, shader);
-        return;
-    }
+    stats += counters;
+}
 
-    const int start_y = std::max(0, i1.y);
-    const int end_y = std::min(static_cast<int>(height - 1), i3.y);
+void RasterizeDepth(Canvas<float>& z_buffer, float far_z, Vec4f screen1, Vec4f screen2,
+                    Vec4f screen3, PipelineStats& stats)
+{
+    TRACE_SCOPE("RasterizeDepth");
 
-    const float triangle_height = (float)(i3.y - i1.y);
+    PipelineStats counters;
+    RasterizeDepthImpl(z_buffer, far_z, screen1, screen2, screen3, counters);
 
-    for (int y = start_y; y <= end_y; ++y)
-    {
-        const bool upper_segment = y >= i2.y;
-        const float t = (y - i1.y) / triangle_height;
-        const float u =
-            upper_segment ? (y - i2.y) / (float)(i3.y - i2.y) : (y - i1.y) / (float)(i2.y - i1.y);
+    stats += counters;
+}
 
-        const int x1 = (int)(i1.x + t * (i3.x - i1.x));
-        const int x2 = (int)(upper_segment ? i2.x + u * (i3.x - i2.x) : i1.x + u * (i2.x - i1.x));
+void RasterizeTriangle(GBuffer& gbuffer, Canvas<float>& z_buffer, float far_z, Vec4f screen1,
+                       Vec4f screen2, Vec4f screen3, const Varyings& v1, const Varyings& v2,
+                       const Varyings& v3, const Shader& shader, PipelineStats& stats)
+{
+    TRACE_SCOPE("RasterizeTriangle");
 
-        auto [start_x, end_x] = MinMax(x1, x2);
+    const BlendState opaque;
+    const PixelOutput out = {gbuffer.albedo, z_buffer, opaque, far_z, &gbuffer.normals};
 
-        if (end_x < 0 || start_x > width - 1)
-            continue;
+    PipelineStats counters;
+    RasterizeTriangleImpl(out, screen1, screen2, screen3, v1, v2, v3, shader, counters);
 
-        if (start_x == end_x)
-        {
-            bar_view = Vec3f{1.0f - t, 0.0f, t};
-            const Vec3f corrected_bar = DoBarPerspectiveCorrection(bar, bar_corr);
-            PutShaderedPixel(canvas, z_buffer, x1, y, corrected_bar * zs, corrected_bar, shader);
-        }
-        else
-        {
-            start_x = start_x < 0 ? 0 : start_x;
-            end_x = end_x >= width ? width - 1 : end_x;
-
-            const float inv_x_length = 1.0f / (x2 - x1);
-            for (int x = start_x; x <= end_x; ++x)
-            {
-                const float s = (x - x1) * inv_x_length;
-
-                if (upper_segment)
-                {
-                    const float b1 = (1.0f - t) * (1.0f - s);
-                    const float b2 = (1.0f - u) * s;
-                    bar_view = Vec3f{b1, b2, 1.0f - b1 - b2};
-                }
-                else
-                {
-                    const float b3 = t * (1.0f - s);
-                    const float b2 = u * s;
-                    bar_view = Vec3f{1.0f - b2 - b3, b2, b3};
-                }
-
-                const Vec3f corrected_bar = DoBarPerspectiveCorrection(bar, bar_corr);
-                PutShaderedPixel(canvas, z_buffer, x, y, corrected_bar * zs, corrected_bar, shader);
-            }
-        }
-    }
+    stats += counters;
 }
 
 } // namespace sr
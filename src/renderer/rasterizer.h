@@ -2,7 +2,10 @@
 #define _RASTERIZER_H_
 
 #include "../common/canvas.h"
+#include "blending.h"
+#include "deferred.h"
 #include "geometry.h"
+#include "pipeline_stats.h"
 #include "shader.h"
 #include "vertex.h"
 
@@ -11,9 +14,26 @@ namespace sr
 void RasterizeRectangle(Image& canvas, int32_t x1, int32_t y1, int32_t x2, int32_t y2, Color color);
 void RasterizeSolidRect(Image& canvas, int32_t x1, int32_t y1, int32_t x2, int32_t y2, Color color);
 void RasterizeLine(Image& canvas, Vec2i p1, Vec2i p2, Color color);
+// Bresenham lines without bounds checks, the endpoints must be clipped to the canvas. The depth
+// tested variant draws pixels whose linearly interpolated z is below the depth buffer plus the
+// bias, the depth buffer must be of the canvas size and is not updated.
+void RasterizeClippedLine(Image& canvas, Vec2i p1, Vec2i p2, Color color);
+void RasterizeClippedLine(Image& canvas, const Canvas<float>& z_buffer, Vec3f p1, Vec3f p2,
+                          Color color, float depth_bias);
 void RasterizeTriangle(Image& canvas, Canvas<float>& z_buffer, float farZ, Vec4f screen1,
-                       Vec4f screen2, Vec4f screen3, const Vertex& v1, const Vertex& v2,
-                       const Vertex& v3, Shader& shader);
+                       Vec4f screen2, Vec4f screen3, const Varyings& v1, const Varyings& v2,
+                       const Varyings& v3, const Shader& shader, const BlendState& blend,
+                       PipelineStats& stats);
+// Depth-only pass, e.g. a depth prepass, shadow maps or occlusion buffers: no shading and no
+// color, only the depth which is linear in screen space is interpolated, the nearer one is kept.
+// Covers the same pixels and writes the same values as RasterizeTriangle.
+void RasterizeDepth(Canvas<float>& z_buffer, float far_z, Vec4f screen1, Vec4f screen2,
+                    Vec4f screen3, PipelineStats& stats);
+// Writes the surface() outputs of the shader to the G-buffer and the depth to the z-buffer,
+// which must be of the G-buffer size
+void RasterizeTriangle(GBuffer& gbuffer, Canvas<float>& z_buffer, float far_z, Vec4f screen1,
+                       Vec4f screen2, Vec4f screen3, const Varyings& v1, const Varyings& v2,
+                       const Varyings& v3, const Shader& shader, PipelineStats& stats);
 } // namespace sr
 
 #endif
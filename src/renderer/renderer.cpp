@@ -1,5 +1,9 @@
 #include "renderer.h"
 
+#include <algorithm>
+
+#include "../common/trace.h"
+
 namespace sr
 {
 
@@ -22,6 +26,25 @@ Vec4f Renderer::ProjectVertex(Vec3f vertex)
     return screen4;
 }
 
+bool Renderer::CullTriangle(const Vec4f& s1, const Vec4f& s2, const Vec4f& s3)
+{
+    // twice the signed area, positive for counterclockwise vertices as y goes up
+    const float area = (s2.x - s1.x) * (s3.y - s1.y) - (s2.y - s1.y) * (s3.x - s1.x);
+    if (area == 0.0f)
+    {
+        ++stats_.triangles_culled_zero_area;
+        return true;
+    }
+
+    if (is_back_face_culling_enabled_ && area < 0.0f)
+    {
+        ++stats_.triangles_culled_back_face;
+        return true;
+    }
+
+    return false;
+}
+
 void Renderer::SetViewport(float x0, float width, float y0, float height, float z0, float depth)
 {
     viewport_matrix_ = Projection::Viewport(x0, width, y0, height, z0, depth);
@@ -34,7 +57,9 @@ void Renderer::SetViewport(float x0, float width, float y0, float height, float
 }
 
 Renderer::Renderer(Image& frame)
-    : frame_(frame), target_(&frame), zbuffer_(frame.width, frame.height), shader_(&default_shader_)
+    : frame_(&frame), target_(&frame), zbuffer_memory_(frame.width, frame.height),
+      zbuffer_(zbuffer_memory_.Data(), frame.width, frame.height),
+      shader_(&default_shader_), is_back_face_culling_enabled_(false), gbuffer_(nullptr)
 {
     SetViewport(0.0, (float)(frame.width), 0.0, (float)(frame.height), 0.0, 255.0);
     Matrices.SetProjection(Projection::Perspective(
@@ -54,6 +79,8 @@ size_t Renderer::Height()
 
 void Renderer::Clear(Color color)
 {
+    TRACE_SCOPE("Renderer::Clear");
+
     target_->Clear(color);
     zbuffer_.Clear(UINT8_MAX);
 }
@@ -73,6 +100,14 @@ void Renderer::DrawSolidRect(int32_t x1, int32_t y1, int32_t x2, int32_t y2, Col
     RasterizeSolidRect(*target_, x1, y1, x2, y2, color);
 }
 
+void Renderer::Blit(const Image& image, int32_t x, int32_t y, bool blend)
+{
+    if (blend)
+        BlendBlit(image, *target_, x, y);
+    else
+        sr::Blit(image, *target_, x, y);
+}
+
 void Renderer::Line(Vec2i p1, Vec2i p2, Color color)
 {
     RasterizeLine(*target_, p1, p2, color);
@@ -95,38 +130,324 @@ void Renderer::TriangleFrame(Vec3f p1, Vec3f p2, Vec3f p3, Color color)
         RasterizeLine(*target_, Project<2, float>(clipped1), Project<2, float>(clipped2), color);
 }
 
+void Renderer::DrawWireframe(const EdgeMesh& mesh, Color color, bool depth_test, float depth_bias)
+{
+    TRACE_SCOPE("Renderer::DrawWireframe");
+
+    // lines are drawn without bounds checks, so they are clipped to the pixel centers
+    Boxf box = viewport_box_;
+    box.xmax = std::min(box.xmax, (float)(target_->width)) - 1.0f;
+    box.ymax = std::min(box.ymax, (float)(target_->height)) - 1.0f;
+    if (box.xmax < box.xmin || box.ymax < box.ymin)
+        return;
+
+    depth_test = depth_test && target_->width == zbuffer_.width &&
+                 target_->height == zbuffer_.height;
+
+    const size_t vertex_count = mesh.positions.size();
+    wire_screen_.resize(vertex_count);
+    wire_codes_.resize(vertex_count);
+    for (size_t i = 0; i < vertex_count; ++i)
+    {
+        wire_screen_[i] = Project<3, float>(ProjectVertex(mesh.positions[i]));
+        wire_codes_[i] = ClipCode(wire_screen_[i], box);
+    }
+
+    for (size_t i = 0; i + 1 < mesh.edges.size(); i += 2)
+    {
+        const uint32_t i1 = mesh.edges[i];
+        const uint32_t i2 = mesh.edges[i + 1];
+        if (wire_codes_[i1] & wire_codes_[i2])
+            continue;
+
+        Vec3f p1 = wire_screen_[i1];
+        Vec3f p2 = wire_screen_[i2];
+        if ((wire_codes_[i1] | wire_codes_[i2]) != 0 &&
+            !ClipLine(wire_screen_[i1], wire_screen_[i2], box, p1, p2))
+            continue;
+
+        if (depth_test)
+        {
+            RasterizeClippedLine(*target_, zbuffer_, p1, p2, color, depth_bias);
+            continue;
+        }
+
+        const Vec2i i1_screen = {(int)(p1.x + 0.5f), (int)(p1.y + 0.5f)};
+        const Vec2i i2_screen = {(int)(p2.x + 0.5f), (int)(p2.y + 0.5f)};
+        RasterizeClippedLine(*target_, i1_screen, i2_screen, color);
+    }
+}
+
 void Renderer::Triangle(Vec3f p1, Vec3f p2, Vec3f p3, Color color)
 {
     DefaultShaders::SolidColor solidColorShader(color);
+    ++stats_.triangles_submitted;
 
     const Vec4f screen1 = ProjectVertex(p1);
     const Vec4f screen2 = ProjectVertex(p2);
     const Vec4f screen3 = ProjectVertex(p3);
+    if (CullTriangle(screen1, screen2, screen3))
+        return;
 
-    const Vertex v1 = p1;
-    const Vertex v2 = p2;
-    const Vertex v3 = p3;
-
-    RasterizeTriangle(*target_, zbuffer_, viewport_box_.zmax, screen1, screen2, screen3, v1, v2, v3,
-                      solidColorShader);
+    const Varyings none = {};
+    DrawTriangle(screen1, screen2, screen3, none, none, none, solidColorShader);
 }
 
 void Renderer::Triangle(const Vertex& v1, const Vertex& v2, const Vertex& v3)
 {
-    shader_->vertex(v1, v2, v3);
+    ++stats_.triangles_submitted;
 
     const Vec4f s1 = ProjectVertex(v1.coord);
     const Vec4f s2 = ProjectVertex(v2.coord);
     const Vec4f s3 = ProjectVertex(v3.coord);
+    if (CullTriangle(s1, s2, s3))
+        return;
+
+    Varyings out1 = {}, out2 = {}, out3 = {};
+    if (shader_->per_triangle)
+    {
+        shader_->triangle(v1, v2, v3, out1, out2, out3);
+    }
+    else
+    {
+        shader_->vertex(v1, out1);
+        shader_->vertex(v2, out2);
+        shader_->vertex(v3, out3);
+    }
+    stats_.vertices_shaded += 3;
+
+    DrawTriangle(s1, s2, s3, out1, out2, out3, *shader_);
+}
+
+void Renderer::DrawTriangle(const Vec4f& s1, const Vec4f& s2, const Vec4f& s3, const Varyings& v1,
+                            const Varyings& v2, const Varyings& v3, const Shader& shader)
+{
+    if (gbuffer_ != nullptr)
+        RasterizeTriangle(*gbuffer_, zbuffer_, viewport_box_.zmax, s1, s2, s3, v1, v2, v3, shader,
+                          stats_);
+    else
+        RasterizeTriangle(*target_, zbuffer_, viewport_box_.zmax, s1, s2, s3, v1, v2, v3, shader,
+                          blend_, stats_);
+}
+
+void Renderer::DrawModel(const Model& model)
+{
+    TRACE_SCOPE("Renderer::DrawModel");
 
-    RasterizeTriangle(*target_, zbuffer_, viewport_box_.zmax, s1, s2, s3, v1, v2, v3, *shader_);
+    for (const Face& face : model.faces)
+        Triangle(face.v[0], face.v[1], face.v[2]);
 }
 
-void Renderer::SetShader(Shader& shader)
+void Renderer::DrawModel(const IndexedModel& model)
+{
+    TRACE_SCOPE("Renderer::DrawModel");
+
+    if (shader_->per_triangle)
+    {
+        for (size_t i = 0; i + 2 < model.indices.size(); i += 3)
+        {
+            const uint32_t* face = &model.indices[i];
+            Triangle(model.vertices[face[0]], model.vertices[face[1]], model.vertices[face[2]]);
+        }
+        return;
+    }
+
+    // the vertex stage runs once per vertex, faces share the results
+    const size_t vertex_count = model.vertices.size();
+    mesh_screen_.resize(vertex_count);
+    mesh_varyings_.resize(vertex_count);
+    for (size_t i = 0; i < vertex_count; ++i)
+    {
+        mesh_screen_[i] = ProjectVertex(model.vertices[i].coord);
+        mesh_varyings_[i] = {};
+        shader_->vertex(model.vertices[i], mesh_varyings_[i]);
+    }
+    stats_.vertices_shaded += vertex_count;
+
+    for (size_t i = 0; i + 2 < model.indices.size(); i += 3)
+    {
+        const uint32_t i1 = model.indices[i];
+        const uint32_t i2 = model.indices[i + 1];
+        const uint32_t i3 = model.indices[i + 2];
+
+        ++stats_.triangles_submitted;
+        if (CullTriangle(mesh_screen_[i1], mesh_screen_[i2], mesh_screen_[i3]))
+            continue;
+
+        DrawTriangle(mesh_screen_[i1], mesh_screen_[i2], mesh_screen_[i3], mesh_varyings_[i1],
+                     mesh_varyings_[i2], mesh_varyings_[i3], *shader_);
+    }
+}
+
+void Renderer::DrawDepth(const Model& model)
+{
+    TRACE_SCOPE("Renderer::DrawDepth");
+
+    for (const Face& face : model.faces)
+    {
+        ++stats_.triangles_submitted;
+        const Vec4f s1 = ProjectVertex(face.v[0].coord);
+        const Vec4f s2 = ProjectVertex(face.v[1].coord);
+        const Vec4f s3 = ProjectVertex(face.v[2].coord);
+        if (!CullTriangle(s1, s2, s3))
+            RasterizeDepth(zbuffer_, viewport_box_.zmax, s1, s2, s3, stats_);
+    }
+}
+
+void Renderer::DrawDepth(const IndexedModel& model)
+{
+    TRACE_SCOPE("Renderer::DrawDepth");
+
+    mesh_screen_.resize(model.vertices.size());
+    for (size_t i = 0; i < model.vertices.size(); ++i)
+        mesh_screen_[i] = ProjectVertex(model.vertices[i].coord);
+
+    for (size_t i = 0; i + 2 < model.indices.size(); i += 3)
+    {
+        const Vec4f& s1 = mesh_screen_[model.indices[i]];
+        const Vec4f& s2 = mesh_screen_[model.indices[i + 1]];
+        const Vec4f& s3 = mesh_screen_[model.indices[i + 2]];
+
+        ++stats_.triangles_submitted;
+        if (!CullTriangle(s1, s2, s3))
+            RasterizeDepth(zbuffer_, viewport_box_.zmax, s1, s2, s3, stats_);
+    }
+}
+
+void Renderer::DrawModel(const LodChain& lods, float max_screen_error)
+{
+    if (lods.levels.empty())
+        return;
+
+    DrawModel(lods.levels[SelectLod(lods, max_screen_error)].model);
+}
+
+float Renderer::ProjectedSphereSize(const Vec3f& center, float radius)
+{
+    const Mat4f model_view = Matrices.GetModelView();
+    const Mat4f projection = Matrices.GetProjection();
+    const Vec4f view_center = model_view * Embed<4, float>(center);
+
+    float scale = 0.0f;
+    for (size_t j = 0; j < 3; ++j)
+        scale = std::max(scale, Project<3, float>(model_view.Column(j)).Norm());
+
+    const float view_radius = radius * scale;
+    const float viewport_height = viewport_box_.ymax - viewport_box_.ymin;
+
+    if (projection[3][3] != 0.0f) // orthographic projection
+        return view_radius * projection[1][1] * viewport_height;
+
+    const float distance = -view_center.z; // camera looks in negative z direction
+    if (distance <= view_radius)
+        return std::numeric_limits<float>::infinity();
+
+    return view_radius * projection[1][1] / distance * viewport_height;
+}
+
+size_t Renderer::SelectLod(const LodChain& lods, float max_screen_error)
+{
+    if (lods.levels.empty() || lods.radius <= 0.0f)
+        return 0;
+
+    const float size = ProjectedSphereSize(lods.center, lods.radius);
+    const float pixels_per_unit = size / (2.0f * lods.radius);
+
+    size_t level = 0;
+    while (level + 1 < lods.levels.size() &&
+           lods.levels[level + 1].error * pixels_per_unit <= max_screen_error)
+        ++level;
+
+    return level;
+}
+
+void Renderer::SetShader(const Shader& shader)
 {
     shader_ = &shader;
 }
 
+void Renderer::SetBackFaceCulling(bool enabled)
+{
+    is_back_face_culling_enabled_ = enabled;
+}
+
+void Renderer::SetDepthTest(DepthTest test)
+{
+    blend_.depth_test = test;
+}
+
+void Renderer::SetBlendMode(BlendMode mode)
+{
+    if (mode == BlendMode::WEIGHTED_OIT && blend_.mode != BlendMode::WEIGHTED_OIT)
+    {
+        oit_.Resize(target_->width, target_->height);
+        oit_.Clear();
+        blend_.oit = &oit_;
+    }
+    blend_.mode = mode;
+}
+
+BlendMode Renderer::GetBlendMode() const
+{
+    return blend_.mode;
+}
+
+void Renderer::ResolveTransparency()
+{
+    TRACE_SCOPE("Renderer::ResolveTransparency");
+
+    if (blend_.oit == nullptr)
+        return;
+
+    ResolveOit(oit_, *target_);
+    blend_.oit = nullptr;
+    if (blend_.mode == BlendMode::WEIGHTED_OIT)
+        blend_.mode = BlendMode::OPAQUE;
+}
+
+void Renderer::BeginGBuffer(GBuffer& gbuffer)
+{
+    gbuffer.Resize(target_->width, target_->height);
+    gbuffer.Clear();
+    gbuffer_ = &gbuffer;
+}
+
+void Renderer::EndGBuffer()
+{
+    gbuffer_ = nullptr;
+}
+
+void Renderer::ShadeLights(const GBuffer& gbuffer, const std::vector<Light>& lights,
+                           const Vec3f& ambient)
+{
+    const Mat4f screen_to_view = Inverse(viewport_matrix_ * Matrices.GetProjection());
+    lighting_.Shade(gbuffer, zbuffer_, screen_to_view, lights, ambient, *target_);
+}
+
+TiledLighting& Renderer::Lighting()
+{
+    return lighting_;
+}
+
+void Renderer::SetFrame(Image& frame)
+{
+    if (target_ == frame_)
+        target_ = &frame;
+    frame_ = &frame;
+
+    if (frame.width != zbuffer_.width || frame.height != zbuffer_.height)
+        Resize(frame.width, frame.height);
+}
+
+void Renderer::Resize(size_t width, size_t height)
+{
+    if (width * height > zbuffer_memory_.width * zbuffer_memory_.height)
+        zbuffer_memory_.Resize(width, height);
+    zbuffer_ = Canvas<float>(zbuffer_memory_.Data(), width, height);
+
+    SetViewport(0.0, (float)(width), 0.0, (float)(height), 0.0, 255.0);
+}
+
 void Renderer::SetDrawTarget(Image& target)
 {
     target_ = &target;
@@ -134,7 +455,7 @@ void Renderer::SetDrawTarget(Image& target)
 
 void Renderer::ResetDrawTarget()
 {
-    target_ = &frame_;
+    target_ = frame_;
 }
 
 void Renderer::DumpTargetScreen(const char* path) const
@@ -142,4 +463,24 @@ void Renderer::DumpTargetScreen(const char* path) const
     DumpTga(path, *target_);
 }
 
+void Renderer::DumpTargetScreen(FrameWriter& writer, const std::string& path, FrameFormat format)
+{
+    writer.Submit(*target_, path, format);
+}
+
+int Renderer::StreamTargetScreen(VideoStream& stream) const
+{
+    return stream.WriteFrame(*target_);
+}
+
+const PipelineStats& Renderer::Stats() const
+{
+    return stats_;
+}
+
+void Renderer::ResetStats()
+{
+    stats_ = PipelineStats();
+}
+
 } // namespace sr
@@ -1,12 +1,20 @@
 #ifndef _RENDERER_H_
 #define _RENDERER_H_
 
+#include "../common/blit.h"
 #include "../common/canvas.h"
+#include "../common/frame_writer.h"
+#include "../common/video_stream.h"
+#include "blending.h"
 #include "clipping.h"
+#include "deferred.h"
+#include "lod.h"
 #include "rasterizer.h"
 #include "shader.h"
 #include "transforms.h"
 #include "matrix_stack.h"
+#include "pipeline_stats.h"
+#include "wireframe.h"
 
 namespace sr
 {
@@ -26,17 +34,69 @@ class Renderer
     void SetPixel(int32_t x, int32_t y, Color color);
     void DrawRect(int32_t x1, int32_t y1, int32_t x2, int32_t y2, Color color);
     void DrawSolidRect(int32_t x1, int32_t y1, int32_t x2, int32_t y2, Color color);
+    // draws the image with its lower left corner at (x, y), blending uses the alpha of the image
+    void Blit(const Image& image, int32_t x, int32_t y, bool blend = false);
     void Line(Vec2i p1, Vec2i p2, Color color);
     void TriangleFrame(Vec3f p1, Vec3f p2, Vec3f p3, Color color);
+    // Projects every vertex once and draws every edge once. With the depth test the lines are
+    // hidden behind what is already in the depth buffer, the bias keeps the edges of the surfaces
+    // they belong to visible.
+    void DrawWireframe(const EdgeMesh& mesh, Color color, bool depth_test = false,
+                       float depth_bias = 0.5f);
     void Triangle(Vec3f p1, Vec3f p2, Vec3f p3, Color color);
     void Triangle(const Vertex& v1, const Vertex& v2, const Vertex& v3);
-
-    void SetShader(Shader& shader);
-
+    void DrawModel(const Model& model);
+    // Runs the vertex stage once per vertex unless the shader works per triangle
+    void DrawModel(const IndexedModel& model);
+    void DrawModel(const LodChain& lods, float max_screen_error = 1.0f);
+    // Depth-only drawing without shaders and colors, e.g. for a depth prepass. Drawing the same
+    // geometry afterwards with DepthTest::LESS_EQUAL shades only the visible pixels.
+    void DrawDepth(const Model& model);
+    void DrawDepth(const IndexedModel& model);
+
+    // diameter in pixels of a model space sphere projected with the current matrices
+    float ProjectedSphereSize(const Vec3f& center, float radius);
+    size_t SelectLod(const LodChain& lods, float max_screen_error = 1.0f);
+
+    // The shader is only read, renderers on different threads can share one
+    void SetShader(const Shader& shader);
+    // Skips triangles whose vertices are clockwise on the screen, off by default
+    void SetBackFaceCulling(bool enabled);
+    void SetDepthTest(DepthTest test);
+
+    // Blended modes test the depth without writing it, draw the opaque geometry first. Switching
+    // to WEIGHTED_OIT clears the transparency buffers, ResolveTransparency composites them onto
+    // the target and switches back to OPAQUE, so transparent triangles need no sorting.
+    void SetBlendMode(BlendMode mode);
+    BlendMode GetBlendMode() const;
+    void ResolveTransparency();
+
+    // Deferred shading. Draws between BeginGBuffer and EndGBuffer write the surface() outputs of
+    // the shader to the G-buffer, which is resized to the target and cleared, and the depth to
+    // the z-buffer. ShadeLights then lights the covered pixels of the target, the lights and the
+    // normals are in view space (see SetNormCorrection of the shaders).
+    void BeginGBuffer(GBuffer& gbuffer);
+    void EndGBuffer();
+    void ShadeLights(const GBuffer& gbuffer, const std::vector<Light>& lights,
+                     const Vec3f& ambient = Vec3f{0.0f, 0.0f, 0.0f});
+    // thread count and per tile statistics of ShadeLights
+    TiledLighting& Lighting();
+
+    // Switches to another frame, e.g. the next buffer of a swap chain. A frame of another size
+    // changes the viewport, the depth buffer is reallocated only when it grows.
+    void SetFrame(Image& frame);
     void SetDrawTarget(Image& target);
     void ResetDrawTarget();
 
     void DumpTargetScreen(const char* path) const;
+    // Hands the target over to the writer without copying, the target is left with stale content
+    void DumpTargetScreen(FrameWriter& writer, const std::string& path,
+                          FrameFormat format = FrameFormat::TGA);
+    int StreamTargetScreen(VideoStream& stream) const;
+
+    // counters since the last reset, Program resets them before drawing every frame
+    const PipelineStats& Stats() const;
+    void ResetStats();
 
     MatrixStack Matrices;
 
@@ -44,16 +104,39 @@ class Renderer
     Mat4f viewport_matrix_;
     Boxf viewport_box_;
 
-    Canvas<float> zbuffer_;
-    Image& frame_;
+    Canvas<float> zbuffer_memory_;
+    Canvas<float> zbuffer_; // wraps zbuffer_memory_ at the size of the frame
+    Image* frame_;
     Image* target_;
 
     DefaultShaders::FlatLight default_shader_;
-    Shader* shader_;
+    const Shader* shader_;
+
+    bool is_back_face_culling_enabled_;
+    PipelineStats stats_;
+
+    BlendState blend_;
+    OitBuffers oit_;
+
+    GBuffer* gbuffer_;
+    TiledLighting lighting_;
+
+    // per vertex scratch of DrawWireframe
+    std::vector<Vec3f> wire_screen_;
+    std::vector<uint8_t> wire_codes_;
+    // per vertex scratch of indexed DrawModel
+    std::vector<Vec4f> mesh_screen_;
+    std::vector<Varyings> mesh_varyings_;
 
     Vec4f ProjectVertex(Vec3f vertex);
+    // rasterizes to the target or to the G-buffer
+    void DrawTriangle(const Vec4f& s1, const Vec4f& s2, const Vec4f& s3, const Varyings& v1,
+                      const Varyings& v2, const Varyings& v3, const Shader& shader);
+    // true if the projected triangle is culled before rasterization
+    bool CullTriangle(const Vec4f& s1, const Vec4f& s2, const Vec4f& s3);
     void SetViewport(float x0, float width, float y0, float height, float z0, float depth);
     void UpdateMatrices();
+    void Resize(size_t width, size_t height);
 };
 
 } // namespace sr
@@ -3,16 +3,79 @@
 
 #include "../common/canvas.h"
 #include "geometry.h"
+#include "shadow.h"
+#include "texture.h"
 #include "vertex.h"
 
 namespace sr
 {
 
+// Outputs of the vertex stage, interpolated with perspective correction by the rasterizer. Only
+// the first varying_count floats of the shader are used.
+const size_t MAX_VARYINGS = 16;
+
+struct Varyings
+{
+    alignas(16) float v[MAX_VARYINGS];
+
+    template <size_t n>
+    Vec<n, float> Get(size_t offset) const
+    {
+        Vec<n, float> result;
+        for (size_t i = 0; i < n; ++i)
+            result[i] = v[offset + i];
+        return result;
+    }
+
+    template <size_t n>
+    void Set(size_t offset, const Vec<n, float>& value)
+    {
+        for (size_t i = 0; i < n; ++i)
+            v[offset + i] = value[i];
+    }
+};
+
+// Per thread state of the pixel stage for the current triangle
+struct ShaderContext
+{
+    // screen-space derivatives of the varyings, filled if the shader needs_derivatives
+    Varyings dx;
+    Varyings dy;
+};
+
+// The stages are const: uniforms are the shader's fields, which must not change during a draw,
+// and everything that changes per vertex, triangle or pixel is passed in. So one shader can be
+// used by renderers on several threads at once.
 class Shader
 {
   public:
-    virtual bool pixel(Vec3f bar, Color& result_color) = 0;
-    virtual void vertex(const Vertex& v1, const Vertex& v2, const Vertex& v3) = 0;
+    virtual ~Shader() = default;
+
+    // Vertex stage. The outputs depend only on the vertex, so the renderer runs it once per vertex
+    // of an indexed model and shares the results between faces.
+    virtual void vertex(const Vertex& v, Varyings& out) const = 0;
+
+    // Shaders which need the whole triangle, e.g. for flat shading, set per_triangle and override
+    // triangle(), which runs instead of vertex() for every triangle
+    bool per_triangle = false;
+    virtual void triangle(const Vertex& v1, const Vertex& v2, const Vertex& v3, Varyings& out1,
+                          Varyings& out2, Varyings& out3) const
+    {}
+
+    virtual bool pixel(const Varyings& in, const ShaderContext& context,
+                       Color& result_color) const = 0;
+
+    // Pixel stage of the G-buffer pass, see GBuffer: the unlit color and the unit normal in view
+    // space. Shaders without it cannot draw to a G-buffer, their pixels are discarded.
+    virtual bool surface(const Varyings& in, const ShaderContext& context, Color& albedo,
+                         Vec3f& normal) const
+    {
+        return false;
+    }
+
+    size_t varying_count = 0;
+    // if set, the rasterizer fills the derivatives of the context before each call of pixel()
+    bool needs_derivatives = false;
 };
 
 namespace impl
@@ -66,6 +129,34 @@ class SupportsGlobalLight
   protected:
     Vec3f minus_light_direction_ = Vec3f{0.0f, 0.0f, 1.0f};
 };
+
+class SupportsShadows
+{
+  public:
+    // model moves the vertices to the world of the shadow map, nullptr turns shadows off
+    void SetShadowMap(const ShadowMap* map, const Mat4f& model = Mat4f::Identity())
+    {
+        shadow_map_ = map;
+        shadow_model_ = model;
+    }
+
+    float shadow_bias = 1.0f;
+
+  protected:
+    Vec3f ToShadowWorld(const Vec3f& position) const
+    {
+        return Project<3>(shadow_model_ * Embed<4>(position));
+    }
+
+    float ShadowVisibility(const Vec3f& world) const
+    {
+        return shadow_map_ != nullptr ? shadow_map_->Visibility(world, shadow_bias) : 1.0f;
+    }
+
+  private:
+    const ShadowMap* shadow_map_ = nullptr;
+    Mat4f shadow_model_ = Mat4f::Identity();
+};
 }; // namespace impl
 
 namespace DefaultShaders
@@ -74,27 +165,75 @@ class SmoothLight : public Shader,
                     public impl::SupportsNormalCorrection,
                     public impl::SupportsGlobalLight
 {
-    Vec3f norm1_, norm2_, norm3_;
-
   public:
     Color color = Color(255, 255, 255);
     float ambient_light_intensity = 0.0f;
 
-    virtual void vertex(const Vertex& v1, const Vertex& v2, const Vertex& v3) override
+    SmoothLight()
+    {
+        varying_count = 3;
+    }
+
+    virtual void vertex(const Vertex& v, Varyings& out) const override
     {
-        norm1_ = CorrectNormal(v1.norm);
-        norm2_ = CorrectNormal(v2.norm);
-        norm3_ = CorrectNormal(v3.norm);
+        out.Set(0, CorrectNormal(v.norm));
     }
 
-    virtual bool pixel(Vec3f bar, Color& result_color) override
+    virtual bool pixel(const Varyings& in, const ShaderContext& context,
+                       Color& result_color) const override
     {
-        const Vec3f norm = bar[0] * norm1_ + bar[1] * norm2_ + bar[2] * norm3_;
+        const Vec3f norm = in.Get<3>(0);
         const float dot = minus_light_direction_ * norm;
         const float intensity = dot > 0 ? dot : 0;
         const float coef =
             ambient_light_intensity + (1.0f - ambient_light_intensity) * intensity;
         result_color = Color(color.r * coef, color.g * coef, color.b * coef);
+        result_color.a = color.a;
+        return true;
+    }
+
+    virtual bool surface(const Varyings& in, const ShaderContext& context, Color& albedo,
+                         Vec3f& normal) const override
+    {
+        albedo = color;
+        normal = Normalize(in.Get<3>(0));
+        return true;
+    }
+};
+
+// SmoothLight with the light blocked where the shadow map sees an occluder
+class ShadowedLight : public Shader,
+                      public impl::SupportsNormalCorrection,
+                      public impl::SupportsGlobalLight,
+                      public impl::SupportsShadows
+{
+  public:
+    Color color = Color(255, 255, 255);
+    float ambient_light_intensity = 0.0f;
+
+    ShadowedLight()
+    {
+        varying_count = 6;
+    }
+
+    // the normal, then the world position
+    virtual void vertex(const Vertex& v, Varyings& out) const override
+    {
+        out.Set(0, CorrectNormal(v.norm));
+        out.Set(3, ToShadowWorld(v.coord));
+    }
+
+    virtual bool pixel(const Varyings& in, const ShaderContext& context,
+                       Color& result_color) const override
+    {
+        const Vec3f norm = in.Get<3>(0);
+        const float dot = minus_light_direction_ * norm;
+        // surfaces facing away from the light need no lookup
+        const float intensity = dot > 0 ? dot * ShadowVisibility(in.Get<3>(3)) : 0;
+        const float coef =
+            ambient_light_intensity + (1.0f - ambient_light_intensity) * intensity;
+        result_color = Color(color.r * coef, color.g * coef, color.b * coef);
+        result_color.a = color.a;
         return true;
     }
 };
@@ -103,37 +242,45 @@ class SmoothTexture : public Shader,
                       public impl::SupportsNormalCorrection,
                       public impl::SupportsGlobalLight
 {
-    const Image& texture;
-
-    Vec3f us;
-    Vec3f vs;
-    Vec3f norm1, norm2, norm3;
+    const Texture& texture;
 
   public:
-    SmoothTexture(const Image& texture) : texture(texture)
-    {}
+    Sampler sampler;
+
+    SmoothTexture(const Texture& texture) : texture(texture)
+    {
+        varying_count = 5;
+        needs_derivatives = true;
+    }
 
-    virtual void vertex(const Vertex& v1, const Vertex& v2, const Vertex& v3) override
+    // uv, then the normal
+    virtual void vertex(const Vertex& v, Varyings& out) const override
     {
-        us = Vec3f{v1.tex.x, v2.tex.x, v3.tex.x};
-        vs = Vec3f{v1.tex.y, v2.tex.y, v3.tex.y};
-        norm1 = v1.norm;
-        norm2 = v2.norm;
-        norm3 = v3.norm;
+        out.Set(0, v.tex);
+        out.Set(2, v.norm);
     }
 
-    virtual bool pixel(Vec3f bar, Color& result_color) override
+    virtual bool pixel(const Varyings& in, const ShaderContext& context,
+                       Color& result_color) const override
     {
-        const Vec3f norm = bar[0] * norm1 + bar[1] * norm2 + bar[2] * norm3;
+        const Vec3f norm = in.Get<3>(2);
         const float dot = minus_light_direction_ * norm;
         const float intensity = dot > 0 ? dot : 0;
 
-        const float u = bar * us;
-        const float v = bar * vs;
-        const Color color = texture.AtSafe(std::round(u * (texture.width - 1)),
-                                           std::round(v * (texture.height - 1)));
+        const Color color =
+            sampler.Sample(texture, in.Get<2>(0), context.dx.Get<2>(0), context.dy.Get<2>(0));
 
         result_color = Color(color.r * intensity, color.g * intensity, color.b * intensity);
+        result_color.a = color.a;
+        return true;
+    }
+
+    virtual bool surface(const Varyings& in, const ShaderContext& context, Color& albedo,
+                         Vec3f& normal) const override
+    {
+        albedo =
+            sampler.Sample(texture, in.Get<2>(0), context.dx.Get<2>(0), context.dy.Get<2>(0));
+        normal = Normalize(in.Get<3>(2));
         return true;
     }
 };
@@ -146,13 +293,18 @@ class FlatLight : public Shader,
     Color color = Color(255, 255, 255);
     float ambient_light_intensity = 0.1f;
 
-    virtual bool pixel(Vec3f bar, Color& result_color) override
+    FlatLight()
     {
-        result_color = result_color_;
-        return true;
+        per_triangle = true;
+        varying_count = 4;
     }
 
-    virtual void vertex(const Vertex& v1, const Vertex& v2, const Vertex& v3) override
+    virtual void vertex(const Vertex& v, Varyings& out) const override
+    {}
+
+    // the lit color of the face is the same at all vertices, so it is interpolated exactly
+    virtual void triangle(const Vertex& v1, const Vertex& v2, const Vertex& v3, Varyings& out1,
+                          Varyings& out2, Varyings& out3) const override
     {
         const Vec3f model_norm = Cross(v3.coord - v1.coord, v2.coord - v1.coord);
         const Vec3f norm = Normalize(CorrectNormal(model_norm));
@@ -160,36 +312,48 @@ class FlatLight : public Shader,
         const float light_intensity = cross > 0 ? cross : 0;
         const float coef =
             ambient_light_intensity + (1.0f - ambient_light_intensity) * light_intensity;
-        result_color_ = Color(color.r * coef, color.g * coef, color.b * coef);
+        const Color result = Color(color.r * coef, color.g * coef, color.b * coef);
+
+        const Vec4f channels = {(float)(result.r), (float)(result.g), (float)(result.b),
+                                (float)(color.a)};
+        out1.Set(0, channels);
+        out2.Set(0, channels);
+        out3.Set(0, channels);
     }
 
-  private:
-    Color result_color_;
+    virtual bool pixel(const Varyings& in, const ShaderContext& context,
+                       Color& result_color) const override
+    {
+        result_color = Color((uint8_t)(in.v[0]), (uint8_t)(in.v[1]), (uint8_t)(in.v[2]));
+        result_color.a = (uint8_t)(in.v[3]);
+        return true;
+    }
 };
 
 class FlatTexture : public Shader
 {
-    Vec3f us;
-    Vec3f vs;
-    const Image& texture;
+    const Texture& texture;
 
   public:
-    FlatTexture(const Image& texture) : texture(texture)
-    {}
+    Sampler sampler;
 
-    virtual bool pixel(Vec3f bar, Color& result_color) override
+    FlatTexture(const Texture& texture) : texture(texture)
     {
-        const float u = bar * us;
-        const float v = bar * vs;
-        result_color = texture.AtSafe(std::round(u * (texture.width - 1)),
-                                      std::round(v * (texture.height - 1)));
-        return true;
+        varying_count = 2;
+        needs_derivatives = true;
     }
 
-    virtual void vertex(const Vertex& v1, const Vertex& v2, const Vertex& v3) override
+    virtual void vertex(const Vertex& v, Varyings& out) const override
     {
-        us = Vec3f{v1.tex.x, v2.tex.x, v3.tex.x};
-        vs = Vec3f{v1.tex.y, v2.tex.y, v3.tex.y};
+        out.Set(0, v.tex);
+    }
+
+    virtual bool pixel(const Varyings& in, const ShaderContext& context,
+                       Color& result_color) const override
+    {
+        result_color =
+            sampler.Sample(texture, in.Get<2>(0), context.dx.Get<2>(0), context.dy.Get<2>(0));
+        return true;
     }
 };
 
@@ -202,14 +366,15 @@ class SolidColor : public Shader
     SolidColor(const Color& color) : color(color)
     {}
 
-    virtual bool pixel(Vec3f bar, Color& result_color) override
+    virtual void vertex(const Vertex& v, Varyings& out) const override
+    {}
+
+    virtual bool pixel(const Varyings& in, const ShaderContext& context,
+                       Color& result_color) const override
     {
         result_color = color;
         return true;
     }
-
-    virtual void vertex(const Vertex& v1, const Vertex& v2, const Vertex& v3) override
-    {}
 };
 } // namespace DefaultShaders
 
@@ -0,0 +1,138 @@
+#include "shadow.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "../common/trace.h"
+#include "rasterizer.h"
+#include "transforms.h"
+
+namespace sr
+{
+
+namespace
+{
+const float MAP_DEPTH = 255.0f;
+
+// as Renderer::ProjectVertex, w is kept for the perspective correction
+Vec4f ToMap(const Mat4f& light, const Mat4f& viewport, const Vec3f& position)
+{
+    Vec4f cs = light * Embed<4, float>(position);
+    if (cs.w == 0.0f)
+        cs.w = 0.0001f;
+
+    const float inv_abs_w = std::fabs(1.0f / cs.w);
+    Vec4f screen = viewport * Vec4f{cs.x * inv_abs_w, cs.y * inv_abs_w, cs.z * inv_abs_w, 1.0f};
+    screen.w = cs.w;
+    return screen;
+}
+} // namespace
+
+ShadowMap::ShadowMap(size_t width, size_t height)
+    : light_(Mat4f::Identity()), is_static_valid_(false), static_renders_(0),
+      static_depth_(width, height), depth_(width, height)
+{
+    depth_.Fill(MAP_DEPTH);
+}
+
+void ShadowMap::SetLight(const Mat4f& view, const Mat4f& projection)
+{
+    const Mat4f light = projection * view;
+    if (!(light == light_))
+    {
+        light_ = light;
+        is_static_valid_ = false;
+    }
+}
+
+void ShadowMap::InvalidateStatic()
+{
+    is_static_valid_ = false;
+}
+
+void ShadowMap::Update(const std::vector<ShadowCaster>& static_casters,
+                       const std::vector<ShadowCaster>& dynamic_casters)
+{
+    TRACE_SCOPE("ShadowMap::Update");
+
+    if (!is_static_valid_)
+    {
+        static_depth_.Fill(MAP_DEPTH);
+        Render(static_casters, static_depth_);
+        is_static_valid_ = true;
+        ++static_renders_;
+    }
+
+    memcpy(depth_.Data(), static_depth_.Data(), sizeof(float) * depth_.width * depth_.height);
+    Render(dynamic_casters, depth_);
+}
+
+void ShadowMap::Render(const std::vector<ShadowCaster>& casters, Canvas<float>& depth)
+{
+    const Mat4f viewport =
+        Projection::Viewport(0.0f, (float)(depth.width), 0.0f, (float)(depth.height));
+    for (const ShadowCaster& caster : casters)
+    {
+        const Mat4f light = light_ * caster.transform;
+        const IndexedModel& model = *caster.model;
+
+        screen_.resize(model.vertices.size());
+        for (size_t i = 0; i < model.vertices.size(); ++i)
+            screen_[i] = ToMap(light, viewport, model.vertices[i].coord);
+
+        // both sides cast shadows, zero area triangles are skipped by the rasterizer
+        for (size_t i = 0; i + 2 < model.indices.size(); i += 3)
+        {
+            ++stats_.triangles_submitted;
+            RasterizeDepth(depth, MAP_DEPTH, screen_[model.indices[i]],
+                           screen_[model.indices[i + 1]], screen_[model.indices[i + 2]], stats_);
+        }
+    }
+}
+
+float ShadowMap::Visibility(const Vec3f& world, float bias) const
+{
+    const Vec4f cs = light_ * Embed<4, float>(world);
+    if (cs.w <= 0.0f)
+        return 1.0f;
+
+    const float x = (cs.x / cs.w + 1.0f) * 0.5f * depth_.width;
+    const float y = (cs.y / cs.w + 1.0f) * 0.5f * depth_.height;
+    const float z = (cs.z / cs.w + 1.0f) * 0.5f * MAP_DEPTH - bias;
+    if (x < 0.0f || y < 0.0f || x >= depth_.width || y >= depth_.height)
+        return 1.0f;
+
+    const int max_x = (int)(depth_.width) - 1;
+    const int max_y = (int)(depth_.height) - 1;
+    const int center_x = (int)(x);
+    const int center_y = (int)(y);
+
+    int lit = 0;
+    for (int dy = -1; dy <= 1; ++dy)
+    {
+        for (int dx = -1; dx <= 1; ++dx)
+        {
+            const int tx = std::clamp(center_x + dx, 0, max_x);
+            const int ty = std::clamp(center_y + dy, 0, max_y);
+            lit += z <= depth_.At(tx, ty) ? 1 : 0;
+        }
+    }
+    return lit / 9.0f;
+}
+
+const Canvas<float>& ShadowMap::Depth() const
+{
+    return depth_;
+}
+
+size_t ShadowMap::StaticRenders() const
+{
+    return static_renders_;
+}
+
+const PipelineStats& ShadowMap::Stats() const
+{
+    return stats_;
+}
+
+} // namespace sr
@@ -0,0 +1,64 @@
+#ifndef _SHADOW_H_
+#define _SHADOW_H_
+
+#include "../common/canvas.h"
+#include "geometry.h"
+#include "model.h"
+#include "pipeline_stats.h"
+
+#include <vector>
+
+namespace sr
+{
+
+// A model placed in the world for the shadow pass
+struct ShadowCaster
+{
+    const IndexedModel* model;
+    Mat4f transform = Mat4f::Identity();
+};
+
+// Depth of the scene seen from a light, rendered by the depth-only rasterizer. Static casters are
+// rendered into a cached layer only when the light moves or InvalidateStatic is called. Every
+// Update copies that layer and adds the dynamic casters on top of it, so a frame pays only for
+// what moves.
+class ShadowMap
+{
+  public:
+    ShadowMap(size_t width, size_t height);
+
+    // World to light space, e.g. LookAt and Ortho for a directional light. A change of the
+    // matrices invalidates the static layer.
+    void SetLight(const Mat4f& view, const Mat4f& projection);
+    // call when static casters were added, removed or moved
+    void InvalidateStatic();
+
+    void Update(const std::vector<ShadowCaster>& static_casters,
+                const std::vector<ShadowCaster>& dynamic_casters);
+
+    // Fraction of the 3x3 percentage-closer filter taps around the world position which are not
+    // occluded, 1 outside of the map. The bias in depth units of the map hides self-shadowing.
+    // Const and thread safe, shaders can call it from pixel().
+    float Visibility(const Vec3f& world, float bias = 1.0f) const;
+
+    const Canvas<float>& Depth() const;
+    // times the static layer has been rendered
+    size_t StaticRenders() const;
+    const PipelineStats& Stats() const;
+
+  private:
+    Mat4f light_; // projection * view
+    bool is_static_valid_;
+    size_t static_renders_;
+
+    Canvas<float> static_depth_;
+    Canvas<float> depth_;
+    std::vector<Vec4f> screen_;
+    PipelineStats stats_;
+
+    void Render(const std::vector<ShadowCaster>& casters, Canvas<float>& depth);
+};
+
+} // namespace sr
+
+#endif
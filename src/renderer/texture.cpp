@@ -0,0 +1,202 @@
+#include "texture.h"
+
+#include <algorithm>
+
+#include "../common/trace.h"
+
+namespace sr
+{
+
+namespace
+{
+Color Average(Color c1, Color c2, Color c3, Color c4)
+{
+    Color result;
+    result.b = (uint8_t)((c1.b + c2.b + c3.b + c4.b + 2) >> 2);
+    result.g = (uint8_t)((c1.g + c2.g + c3.g + c4.g + 2) >> 2);
+    result.r = (uint8_t)((c1.r + c2.r + c3.r + c4.r + 2) >> 2);
+    result.a = (uint8_t)((c1.a + c2.a + c3.a + c4.a + 2) >> 2);
+    return result;
+}
+
+// lerps two packed BGRA colors by t in [0, 256], two channels at a time
+uint32_t Lerp(uint32_t c1, uint32_t c2, uint32_t t)
+{
+    const uint32_t rb1 = c1 & 0x00ff00ff;
+    const uint32_t ag1 = (c1 >> 8) & 0x00ff00ff;
+    const uint32_t rb2 = c2 & 0x00ff00ff;
+    const uint32_t ag2 = (c2 >> 8) & 0x00ff00ff;
+    const uint32_t rb = ((rb1 * (256 - t) + rb2 * t) >> 8) & 0x00ff00ff;
+    const uint32_t ag = (ag1 * (256 - t) + ag2 * t) & 0xff00ff00;
+    return rb | ag;
+}
+
+uint32_t Weight(float t)
+{
+    return (uint32_t)(t * 256.0f + 0.5f);
+}
+
+Image Downsample(const Image& src)
+{
+    Image dst(std::max<size_t>(1, src.width / 2), std::max<size_t>(1, src.height / 2));
+
+    for (size_t y = 0; y < dst.height; ++y)
+    {
+        const size_t y0 = std::min(2 * y, src.height - 1);
+        const size_t y1 = std::min(2 * y + 1, src.height - 1);
+        for (size_t x = 0; x < dst.width; ++x)
+        {
+            const size_t x0 = std::min(2 * x, src.width - 1);
+            const size_t x1 = std::min(2 * x + 1, src.width - 1);
+            dst.At(x, y) =
+                Average(src.At(x0, y0), src.At(x1, y0), src.At(x0, y1), src.At(x1, y1));
+        }
+    }
+
+    return dst;
+}
+
+} // namespace
+
+Texture::Texture(const Image& image)
+{
+    Build(image);
+}
+
+void Texture::Build(const Image& image)
+{
+    levels_.clear();
+    if (image.width == 0 || image.height == 0)
+        return;
+
+    levels_.push_back(TiledImage(image));
+
+    Image level;
+    const Image* previous = &image;
+    while (previous->width > 1 || previous->height > 1)
+    {
+        level = Downsample(*previous);
+        levels_.push_back(TiledImage(level));
+        previous = &level;
+    }
+}
+
+size_t Texture::Width() const
+{
+    return levels_.empty() ? 0 : levels_[0].width;
+}
+
+size_t Texture::Height() const
+{
+    return levels_.empty() ? 0 : levels_[0].height;
+}
+
+size_t Texture::Levels() const
+{
+    return levels_.size();
+}
+
+const TiledImage& Texture::Level(size_t level) const
+{
+    return levels_[level];
+}
+
+float Texture::LevelOfDetail(Vec2f duv_dx, Vec2f duv_dy) const
+{
+    const Vec2f size = {(float)Width(), (float)Height()};
+    const Vec2f dx = {duv_dx.x * size.x, duv_dx.y * size.y};
+    const Vec2f dy = {duv_dy.x * size.x, duv_dy.y * size.y};
+    const float rho_squared = std::max(dx * dx, dy * dy);
+    if (rho_squared <= 1.0f)
+        return 0.0f;
+
+    const float lod = 0.5f * std::log2(rho_squared);
+    return std::min(lod, (float)(levels_.size() - 1));
+}
+
+size_t Sampler::Address(int coord, size_t size) const
+{
+    if (wrap == TextureWrap::REPEAT)
+    {
+        if ((size & (size - 1)) == 0)
+            return (size_t)(coord) & (size - 1);
+        const int wrapped = coord % (int)(size);
+        return (size_t)(wrapped < 0 ? wrapped + (int)(size) : wrapped);
+    }
+    return (size_t)(std::min(std::max(coord, 0), (int)(size)-1));
+}
+
+uint32_t Sampler::SampleNearest(const TiledImage& level, Vec2f uv) const
+{
+    const int x = (int)std::floor(uv.x * level.width);
+    const int y = (int)std::floor(uv.y * level.height);
+    return level.At(Address(x, level.width), Address(y, level.height));
+}
+
+uint32_t Sampler::SampleBilinear(const TiledImage& level, Vec2f uv) const
+{
+    const float fx = uv.x * level.width - 0.5f;
+    const float fy = uv.y * level.height - 0.5f;
+    const float floor_x = std::floor(fx);
+    const float floor_y = std::floor(fy);
+
+    uint32_t quad[4];
+    level.Quad(Address((int)floor_x, level.width), Address((int)floor_y, level.height),
+               Address((int)floor_x + 1, level.width), Address((int)floor_y + 1, level.height),
+               quad);
+
+    const uint32_t tx = Weight(fx - floor_x);
+    const uint32_t ty = Weight(fy - floor_y);
+    return Lerp(Lerp(quad[0], quad[1], tx), Lerp(quad[2], quad[3], tx), ty);
+}
+
+Color Sampler::Sample(const Texture& texture, Vec2f uv) const
+{
+    if (texture.Levels() == 0)
+        return Color(0);
+
+    if (filter == TextureFilter::NEAREST)
+        return SampleNearest(texture.Level(0), uv);
+    return SampleBilinear(texture.Level(0), uv);
+}
+
+Color Sampler::Sample(const Texture& texture, Vec2f uv, Vec2f duv_dx, Vec2f duv_dy) const
+{
+    if (texture.Levels() == 0)
+        return Color(0);
+
+    const float lod = texture.LevelOfDetail(duv_dx, duv_dy);
+
+    switch (filter)
+    {
+    case TextureFilter::NEAREST:
+        return SampleNearest(texture.Level((size_t)(lod + 0.5f)), uv);
+    case TextureFilter::BILINEAR:
+        return SampleBilinear(texture.Level((size_t)(lod + 0.5f)), uv);
+    case TextureFilter::TRILINEAR:
+    default:
+    {
+        const size_t level = (size_t)(lod);
+        const uint32_t t = Weight(lod - level);
+        const uint32_t fine = SampleBilinear(texture.Level(level), uv);
+        if (t == 0 || level + 1 >= texture.Levels())
+            return fine;
+        return Lerp(fine, SampleBilinear(texture.Level(level + 1), uv), t);
+    }
+    }
+}
+
+int LoadTexture(const char* path, Texture& result)
+{
+    TRACE_SCOPE("LoadTexture");
+
+    Image image;
+    int status = LoadTGA(path, image);
+    if (status != 0)
+        return status;
+
+    result.Build(image);
+    return 0;
+}
+
+} // namespace sr
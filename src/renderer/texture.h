@@ -0,0 +1,72 @@
+#ifndef _TEXTURE_H_
+#define _TEXTURE_H_
+
+#include <vector>
+
+#include "../common/canvas.h"
+#include "geometry.h"
+#include "tiled_image.h"
+
+namespace sr
+{
+
+enum class TextureFilter
+{
+    NEAREST,  // nearest texel of the nearest mip level
+    BILINEAR, // bilinear filtering inside the nearest mip level
+    TRILINEAR // bilinear filtering blended between two adjacent mip levels
+};
+
+enum class TextureWrap
+{
+    CLAMP,
+    REPEAT
+};
+
+class Texture
+{
+  public:
+    Texture() = default;
+    explicit Texture(const Image& image);
+
+    // Builds the whole mip chain down to 1x1 with a box filter
+    void Build(const Image& image);
+
+    size_t Width() const;
+    size_t Height() const;
+    size_t Levels() const;
+    const TiledImage& Level(size_t level) const;
+
+    float LevelOfDetail(Vec2f duv_dx, Vec2f duv_dy) const;
+
+  private:
+    std::vector<TiledImage> levels_;
+};
+
+class Sampler
+{
+  public:
+    TextureFilter filter = TextureFilter::TRILINEAR;
+    TextureWrap wrap = TextureWrap::CLAMP;
+
+    Sampler() = default;
+    Sampler(TextureFilter filter, TextureWrap wrap) : filter(filter), wrap(wrap)
+    {}
+
+    // Samples the base level
+    Color Sample(const Texture& texture, Vec2f uv) const;
+
+    // duv_dx and duv_dy are screen-space derivatives of uv used for selecting mip level
+    Color Sample(const Texture& texture, Vec2f uv, Vec2f duv_dx, Vec2f duv_dy) const;
+
+  private:
+    uint32_t SampleNearest(const TiledImage& level, Vec2f uv) const;
+    uint32_t SampleBilinear(const TiledImage& level, Vec2f uv) const;
+    size_t Address(int coord, size_t size) const;
+};
+
+int LoadTexture(const char* path, Texture& result);
+
+} // namespace sr
+
+#endif
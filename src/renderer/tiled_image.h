@@ -0,0 +1,114 @@
+#ifndef _TILED_IMAGE_H_
+#define _TILED_IMAGE_H_
+
+#include <vector>
+
+#include "../common/canvas.h"
+
+namespace sr
+{
+
+// Read-only texel storage in 4x4 blocks of 64 bytes, so that every block occupies exactly one
+// cache line. Storage is padded to power of two sizes by replicating edge texels. Coordinates
+// follow Canvas::At, i.e. y grows upwards.
+class TiledImage
+{
+    static const size_t BLOCK_SHIFT = 2;
+    static const size_t BLOCK_MASK = (1 << BLOCK_SHIFT) - 1;
+    static const size_t CACHE_LINE = 64;
+
+  public:
+    size_t width;
+    size_t height;
+
+    TiledImage() : width(0), height(0), padded_width_(0), padded_height_(0), offset_(0)
+    {}
+
+    explicit TiledImage(const Image& image) : width(image.width), height(image.height)
+    {
+        padded_width_ = PowerOfTwo(width);
+        padded_height_ = PowerOfTwo(height);
+        blocks_x_shift_ = Log2(padded_width_) - BLOCK_SHIFT;
+
+        // over-allocate to align the first block with a cache line
+        const size_t count = padded_width_ * padded_height_;
+        storage_.resize(count + CACHE_LINE / sizeof(uint32_t));
+        const size_t misalignment = (size_t)(storage_.data()) % CACHE_LINE;
+        offset_ = misalignment == 0 ? 0 : (CACHE_LINE - misalignment) / sizeof(uint32_t);
+
+        for (size_t y = 0; y < padded_height_; ++y)
+        {
+            const size_t src_y = y < height ? y : height - 1;
+            for (size_t x = 0; x < padded_width_; ++x)
+            {
+                const size_t src_x = x < width ? x : width - 1;
+                storage_[offset_ + Address(x, y)] = image.At(src_x, src_y);
+            }
+        }
+    }
+
+    bool IsPowerOfTwo() const
+    {
+        return padded_width_ == width && padded_height_ == height;
+    }
+
+    size_t Address(size_t x, size_t y) const
+    {
+        const size_t block = ((y >> BLOCK_SHIFT) << blocks_x_shift_) + (x >> BLOCK_SHIFT);
+        return (block << (2 * BLOCK_SHIFT)) | ((y & BLOCK_MASK) << BLOCK_SHIFT) | (x & BLOCK_MASK);
+    }
+
+    uint32_t At(size_t x, size_t y) const
+    {
+        return storage_[offset_ + Address(x, y)];
+    }
+
+    // Fetches texels (x0, y0), (x1, y0), (x0, y1), (x1, y1). When x1 = x0 + 1 and y1 = y0 + 1 do
+    // not cross a block border, all of them come from one cache line.
+    void Quad(size_t x0, size_t y0, size_t x1, size_t y1, uint32_t result[4]) const
+    {
+        const uint32_t* base = storage_.data() + offset_;
+        if (x1 == x0 + 1 && y1 == y0 + 1 && (x0 & BLOCK_MASK) != BLOCK_MASK &&
+            (y0 & BLOCK_MASK) != BLOCK_MASK)
+        {
+            const uint32_t* texel = base + Address(x0, y0);
+            result[0] = texel[0];
+            result[1] = texel[1];
+            result[2] = texel[1 << BLOCK_SHIFT];
+            result[3] = texel[(1 << BLOCK_SHIFT) + 1];
+            return;
+        }
+
+        result[0] = base[Address(x0, y0)];
+        result[1] = base[Address(x1, y0)];
+        result[2] = base[Address(x0, y1)];
+        result[3] = base[Address(x1, y1)];
+    }
+
+  private:
+    static size_t PowerOfTwo(size_t value)
+    {
+        size_t result = 1 << BLOCK_SHIFT;
+        while (result < value)
+            result <<= 1;
+        return result;
+    }
+
+    static size_t Log2(size_t value)
+    {
+        size_t result = 0;
+        while ((size_t(1) << result) < value)
+            ++result;
+        return result;
+    }
+
+    std::vector<uint32_t> storage_;
+    size_t padded_width_;
+    size_t padded_height_;
+    size_t blocks_x_shift_;
+    size_t offset_;
+};
+
+} // namespace sr
+
+#endif
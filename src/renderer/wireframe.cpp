@@ -0,0 +1,78 @@
+#include "wireframe.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+#include "../common/trace.h"
+
+namespace sr
+{
+
+namespace
+{
+struct PositionHash
+{
+    size_t operator()(const Vec3f& v) const
+    {
+        uint32_t bits[3];
+        memcpy(bits, v.v, sizeof(bits));
+        return (size_t)(bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u);
+    }
+};
+
+uint64_t EdgeKey(uint32_t u, uint32_t v)
+{
+    if (u > v)
+        std::swap(u, v);
+    return (uint64_t(u) << 32) | v;
+}
+} // namespace
+
+void BuildEdgeMesh(const Model& model, EdgeMesh& result)
+{
+    TRACE_SCOPE("BuildEdgeMesh");
+
+    result.positions.clear();
+    result.edges.clear();
+
+    std::unordered_map<Vec3f, uint32_t, PositionHash> welded;
+    welded.reserve(model.faces.size());
+
+    // sorting the keys is much faster than a hash set for millions of edges
+    std::vector<uint64_t> keys;
+    keys.reserve(3 * model.faces.size());
+
+    for (const Face& face : model.faces)
+    {
+        uint32_t index[3];
+        for (size_t i = 0; i < 3; ++i)
+        {
+            const auto [iter, inserted] =
+                welded.emplace(face.v[i].coord, (uint32_t)(result.positions.size()));
+            if (inserted)
+                result.positions.push_back(face.v[i].coord);
+            index[i] = iter->second;
+        }
+
+        for (size_t i = 0; i < 3; ++i)
+        {
+            const uint32_t u = index[i];
+            const uint32_t v = index[(i + 1) % 3];
+            if (u != v)
+                keys.push_back(EdgeKey(u, v));
+        }
+    }
+
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    result.edges.resize(2 * keys.size());
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        result.edges[2 * i] = (uint32_t)(keys[i] >> 32);
+        result.edges[2 * i + 1] = (uint32_t)(keys[i]);
+    }
+}
+
+} // namespace sr
@@ -0,0 +1,30 @@
+#ifndef _WIREFRAME_H_
+#define _WIREFRAME_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include "geometry.h"
+#include "model.h"
+
+namespace sr
+{
+
+// Indexed edges of a mesh for wireframe drawing. Vertices are welded by position and every edge
+// shared by several faces is stored once, so each one is projected, clipped and drawn once.
+struct EdgeMesh
+{
+    std::vector<Vec3f> positions;
+    std::vector<uint32_t> edges; // pairs of indices into positions
+
+    size_t EdgeCount() const
+    {
+        return edges.size() / 2;
+    }
+};
+
+void BuildEdgeMesh(const Model& model, EdgeMesh& result);
+
+} // namespace sr
+
+#endif
@@ -0,0 +1,132 @@
+#define CATCH_CONFIG_MAIN
+#include "../renderer/renderer.h"
+#include <catch2/catch.hpp>
+
+using namespace sr;
+
+namespace
+{
+const Color BACKGROUND = Color(0, 0, 200);
+
+Color WithAlpha(Color color, uint8_t alpha)
+{
+    color.a = alpha;
+    return color;
+}
+
+// covers the frame from x0 to x1 in normalized device coordinates
+void Quad(Renderer& renderer, float x0, float x1, float z, Color color)
+{
+    renderer.Triangle(Vec3f{x0, -1.0f, z}, Vec3f{x1, -1.0f, z}, Vec3f{x1, 1.0f, z}, color);
+    renderer.Triangle(Vec3f{x0, -1.0f, z}, Vec3f{x1, 1.0f, z}, Vec3f{x0, 1.0f, z}, color);
+}
+
+void Setup(Renderer& renderer)
+{
+    renderer.Matrices.SetProjection(Mat4f::Identity());
+    renderer.Clear(BACKGROUND);
+}
+
+void CheckColor(Color actual, Color expected)
+{
+    CHECK(abs(actual.r - expected.r) <= 1);
+    CHECK(abs(actual.g - expected.g) <= 1);
+    CHECK(abs(actual.b - expected.b) <= 1);
+}
+} // namespace
+
+TEST_CASE("Blend modes", "[Blending]")
+{
+    Image frame(20, 20);
+    Renderer renderer(frame);
+    Setup(renderer);
+
+    SECTION("alpha")
+    {
+        renderer.SetBlendMode(BlendMode::ALPHA);
+        Quad(renderer, -1.0f, 1.0f, 0.0f, WithAlpha(Color(255, 0, 0), 51));
+        CheckColor(frame.At(10, 10), Color(51, 0, 160));
+    }
+
+    SECTION("additive")
+    {
+        renderer.SetBlendMode(BlendMode::ADDITIVE);
+        Quad(renderer, -1.0f, 1.0f, 0.0f, WithAlpha(Color(100, 0, 100), 255));
+        CheckColor(frame.At(10, 10), Color(100, 0, 255));
+    }
+
+    SECTION("multiply")
+    {
+        renderer.SetBlendMode(BlendMode::MULTIPLY);
+        Quad(renderer, -1.0f, 1.0f, 0.0f, Color(255, 255, 128));
+        CheckColor(frame.At(10, 10), Color(0, 0, 100));
+    }
+}
+
+TEST_CASE("Blended pixels are depth tested but do not write depth", "[Blending]")
+{
+    Image frame(20, 20);
+    Renderer renderer(frame);
+    Setup(renderer);
+
+    // opaque wall in the left half, in front of everything else
+    Quad(renderer, -1.0f, 0.0f, -0.5f, Color(0, 255, 0));
+
+    renderer.SetBlendMode(BlendMode::ALPHA);
+    Quad(renderer, -1.0f, 1.0f, 0.0f, WithAlpha(Color(255, 0, 0), 128));
+    CHECK(frame.At(5, 10) == Color(0, 255, 0));
+
+    // drawn behind the transparent layer, still visible through it
+    renderer.SetBlendMode(BlendMode::OPAQUE);
+    Quad(renderer, 0.0f, 1.0f, 0.5f, Color(255, 255, 255));
+    CHECK(frame.At(15, 10) == Color(255, 255, 255));
+}
+
+TEST_CASE("Weighted blended transparency does not depend on the order", "[Blending]")
+{
+    const Color front = WithAlpha(Color(255, 0, 0), 128);
+    const Color back = WithAlpha(Color(0, 255, 0), 100);
+
+    Image first(20, 20);
+    Renderer renderer1(first);
+    Setup(renderer1);
+    renderer1.SetBlendMode(BlendMode::WEIGHTED_OIT);
+    Quad(renderer1, -1.0f, 0.5f, -0.2f, front);
+    Quad(renderer1, -0.5f, 1.0f, 0.2f, back);
+    renderer1.ResolveTransparency();
+    CHECK(renderer1.GetBlendMode() == BlendMode::OPAQUE);
+
+    Image second(20, 20);
+    Renderer renderer2(second);
+    Setup(renderer2);
+    renderer2.SetBlendMode(BlendMode::WEIGHTED_OIT);
+    Quad(renderer2, -0.5f, 1.0f, 0.2f, back);
+    Quad(renderer2, -1.0f, 0.5f, -0.2f, front);
+    renderer2.ResolveTransparency();
+
+    CHECK(memcmp(first.Data(), second.Data(), sizeof(uint32_t) * 20 * 20) == 0);
+
+    // a single layer is plain alpha blending
+    CheckColor(first.At(2, 10), Color(128, 0, 100));
+    CheckColor(first.At(18, 10), Color(0, 100, 122));
+    // the nearer layer has the larger weight
+    const Color both = first.At(10, 10);
+    CHECK(both.r > both.g);
+    CHECK(first.At(10, 10) != first.At(2, 10));
+}
+
+TEST_CASE("Weighted blended transparency is hidden by opaque geometry", "[Blending]")
+{
+    Image frame(20, 20);
+    Renderer renderer(frame);
+    Setup(renderer);
+
+    Quad(renderer, -1.0f, 0.0f, -0.5f, Color(0, 255, 0));
+
+    renderer.SetBlendMode(BlendMode::WEIGHTED_OIT);
+    Quad(renderer, -1.0f, 1.0f, 0.0f, WithAlpha(Color(255, 0, 0), 128));
+    renderer.ResolveTransparency();
+
+    CHECK(frame.At(5, 10) == Color(0, 255, 0));
+    CheckColor(frame.At(15, 10), Color(128, 0, 100));
+}
@@ -0,0 +1,141 @@
+#define CATCH_CONFIG_MAIN
+#include "../common/blit.h"
+#include "../renderer/rasterizer.h"
+#include <catch2/catch.hpp>
+
+using namespace sr;
+
+namespace
+{
+size_t CountColor(const Image& image, Color color)
+{
+    size_t count = 0;
+    for (size_t y = 0; y < image.height; ++y)
+        for (size_t x = 0; x < image.width; ++x)
+            count += image.At(x, y) == color ? 1 : 0;
+    return count;
+}
+} // namespace
+
+TEST_CASE("Filled rectangles match the pixel loop", "[Blit]")
+{
+    const Color RED = Color(255, 0, 0);
+    const int32_t rects[][4] = {{2, 3, 7, 9},    {7, 9, 2, 3},  {-5, -5, 4, 4},
+                                {6, 6, 30, 30}, {3, 3, 3, 8},  {-9, 2, -1, 5},
+                                {12, 2, 20, 5}, {0, 0, 10, 10}};
+
+    for (const auto& r : rects)
+    {
+        Image expected(10, 10);
+        expected.FillBlack();
+        const int xinc = r[2] > r[0] ? 1 : -1;
+        const int yinc = r[3] > r[1] ? 1 : -1;
+        for (int y = r[1]; y != r[3]; y += yinc)
+            for (int x = r[0]; x != r[2]; x += xinc)
+                expected.SetPixel(x, y, RED);
+
+        Image image(10, 10);
+        image.FillBlack();
+        FillRect(image, r[0], r[1], r[2], r[3], RED);
+
+        CHECK(memcmp(image.Data(), expected.Data(), sizeof(uint32_t) * 100) == 0);
+    }
+}
+
+TEST_CASE("Rectangle outline", "[Blit]")
+{
+    const Color GREEN = Color(0, 255, 0);
+    Image image(10, 10);
+    image.FillBlack();
+
+    RasterizeRectangle(image, 1, 1, 5, 4, GREEN);
+    CHECK(image.At(1, 1) == GREEN);
+    CHECK(image.At(4, 4) == GREEN);
+    CHECK(image.At(5, 3) == GREEN);
+    CHECK(image.At(2, 2) == 0);
+    // the pixel loops never reached (x2, y2)
+    CHECK(image.At(5, 4) == 0);
+    CHECK(CountColor(image, GREEN) == 13);
+}
+
+TEST_CASE("Blits are clipped to the destination", "[Blit]")
+{
+    Image src(4, 3);
+    for (size_t y = 0; y < src.height; ++y)
+        for (size_t x = 0; x < src.width; ++x)
+            src.At(x, y) = Color((uint8_t)(x), (uint8_t)(y), 1);
+
+    Image dst(5, 5);
+    dst.FillBlack();
+
+    SECTION("inside")
+    {
+        Blit(src, dst, 1, 2);
+        CHECK(dst.At(1, 2) == src.At(0, 0));
+        CHECK(dst.At(4, 4) == src.At(3, 2));
+        CHECK(dst.At(0, 2) == 0);
+        CHECK(CountColor(dst, 0) == 25 - 12);
+    }
+
+    SECTION("crossing the bottom left corner")
+    {
+        Blit(src, dst, -2, -1);
+        CHECK(dst.At(0, 0) == src.At(2, 1));
+        CHECK(dst.At(1, 1) == src.At(3, 2));
+        CHECK(CountColor(dst, 0) == 25 - 4);
+    }
+
+    SECTION("outside")
+    {
+        Blit(src, dst, 5, 0);
+        Blit(src, dst, 0, -3);
+        CHECK(CountColor(dst, 0) == 25);
+    }
+}
+
+TEST_CASE("Blits convert formats", "[Blit]")
+{
+    Canvas<uint8_t> gray(2, 1);
+    gray.At(0, 0) = 0;
+    gray.At(1, 0) = 200;
+
+    Image image(2, 1);
+    Blit(gray, image, 0, 0);
+    CHECK(image.At(0, 0) == Color(0, 0, 0));
+    CHECK(image.At(1, 0) == Color(200, 200, 200));
+
+    image.At(0, 0) = Color(255, 0, 0);
+    Canvas<uint8_t> back(2, 1);
+    Blit(image, back, 0, 0);
+    CHECK(back.At(0, 0) == 77);
+    CHECK(back.At(1, 0) == 200);
+}
+
+TEST_CASE("Blending uses the source alpha", "[Blit]")
+{
+    // wider than a SIMD batch so both paths are covered
+    Image src(7, 1);
+    Image dst(7, 1);
+    for (size_t x = 0; x < src.width; ++x)
+    {
+        Color color = Color(200, 100, 0);
+        color.a = (uint8_t)(x * 255 / 6);
+        src.At(x, 0) = color;
+        dst.At(x, 0) = Color(0, 0, 100);
+    }
+
+    BlendBlit(src, dst, 0, 0);
+
+    CHECK(dst.At(0, 0) == Color(0, 0, 100));
+    CHECK(dst.At(6, 0) == Color(200, 100, 0));
+
+    for (size_t x = 0; x < dst.width; ++x)
+    {
+        const Color result = dst.At(x, 0);
+        const float alpha = (x * 255 / 6) / 255.0f;
+        CHECK(result.r == Approx(200 * alpha).margin(0.5f));
+        CHECK(result.g == Approx(100 * alpha).margin(0.5f));
+        CHECK(result.b == Approx(100 * (1 - alpha)).margin(0.5f));
+        CHECK(result.a == 255);
+    }
+}
@@ -0,0 +1,53 @@
+#define CATCH_CONFIG_MAIN
+#include "../common/bmp.h"
+#include <catch2/catch.hpp>
+
+#include <vector>
+
+using namespace sr;
+
+namespace
+{
+uint32_t ReadU32(const uint8_t* ptr)
+{
+    return ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | ((uint32_t)(ptr[3]) << 24);
+}
+} // namespace
+
+TEST_CASE("Color canvas", "[BMP]")
+{
+    Image image(3, 2);
+    for (size_t y = 0; y < image.height; ++y)
+        for (size_t x = 0; x < image.width; ++x)
+            image.At(x, y) = Color((uint8_t)(x), (uint8_t)(y), 0);
+
+    std::vector<uint8_t> buffer(BmpSize(image));
+    MemorySink sink(buffer.data(), buffer.size());
+    REQUIRE(WriteBmp(sink, image) == 0);
+    REQUIRE(sink.Size() == 54 + 3 * 2 * 4);
+
+    CHECK(buffer[0] == 'B');
+    CHECK(ReadU32(&buffer[2]) == buffer.size());
+    CHECK(ReadU32(&buffer[18]) == 3);
+    CHECK((int32_t)(ReadU32(&buffer[22])) == -2);
+
+    // the first row is the top one
+    CHECK(ReadU32(&buffer[54]) == image.At(0, 1));
+    CHECK(ReadU32(&buffer[54 + 4 * 5]) == image.At(2, 0));
+}
+
+TEST_CASE("Grayscale canvas", "[BMP]")
+{
+    Canvas<uint8_t> canvas(3, 2);
+    for (size_t i = 0; i < 6; ++i)
+        canvas.Data()[i] = (uint8_t)(i + 1);
+
+    std::vector<uint8_t> buffer(BmpSize(canvas));
+    MemorySink sink(buffer.data(), buffer.size());
+    REQUIRE(WriteBmp(sink, canvas) == 0);
+
+    // 9 bytes of pixels padded to 12 per row
+    REQUIRE(sink.Size() == 54 + 2 * 12);
+    CHECK(buffer[54 + 12] == 4);
+    CHECK(buffer[54 + 12 + 8] == 6);
+}
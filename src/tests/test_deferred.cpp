@@ -0,0 +1,196 @@
+#define CATCH_CONFIG_MAIN
+#include "../renderer/renderer.h"
+#include <catch2/catch.hpp>
+
+#include <random>
+
+using namespace sr;
+
+namespace
+{
+const size_t WIDTH = 96;
+const size_t HEIGHT = 72;
+const Color BACKGROUND = Color(0, 0, 40);
+
+Mat4f ScreenToView()
+{
+    return Inverse(Projection::Viewport(0.0f, WIDTH, 0.0f, HEIGHT) *
+                   Projection::Perspective(45.0f, (float)(WIDTH) / HEIGHT, 0.05f, 100.0f));
+}
+
+// Slanted floor in the lower two thirds of the frame, the top rows stay uncovered
+void FillGBuffer(GBuffer& gbuffer, Canvas<float>& depth)
+{
+    gbuffer.Resize(WIDTH, HEIGHT);
+    gbuffer.Clear();
+    depth.Resize(WIDTH, HEIGHT);
+    depth.Fill(255.0f);
+
+    for (size_t y = 0; y < HEIGHT * 2 / 3; ++y)
+    {
+        for (size_t x = 0; x < WIDTH; ++x)
+        {
+            depth.At(x, y) = 250.0f + 4.0f * y / HEIGHT;
+            gbuffer.albedo.At(x, y) = Color((uint8_t)(x * 2), 200, (uint8_t)(y * 3));
+            gbuffer.normals.At(x, y) = EncodeNormal(Normalize(Vec3f{0.2f, 1.0f, 0.3f}));
+        }
+    }
+}
+
+std::vector<Light> RandomLights(size_t count, std::mt19937& random)
+{
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<Light> lights(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        Light& light = lights[i];
+        light.position = Vec3f{unit(random) * 8.0f - 4.0f, unit(random) * 4.0f - 3.0f,
+                               -2.0f - unit(random) * 5.0f};
+        light.intensity = Vec3f{unit(random), unit(random), unit(random)};
+        light.radius = 0.3f + unit(random);
+        if (i % 4 == 0)
+        {
+            light.type = LightType::SPOT;
+            light.direction = Vec3f{0.0f, -1.0f, 0.0f};
+            light.cos_inner = 0.9f;
+            light.cos_outer = 0.7f;
+        }
+    }
+    return lights;
+}
+} // namespace
+
+TEST_CASE("Normals are packed into 32 bits", "[Deferred]")
+{
+    std::mt19937 random(3);
+    std::normal_distribution<float> gauss;
+
+    float max_error = 0.0f;
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        const Vec3f normal = Normalize(Vec3f{gauss(random), gauss(random), gauss(random)});
+        const uint32_t encoded = EncodeNormal(normal);
+        CHECK(encoded != 0);
+        max_error = std::max(max_error, (DecodeNormal(encoded) - normal).Norm());
+    }
+    CHECK(max_error < 1e-3f);
+
+    const Vec3f down = {0.0f, 0.0f, -1.0f};
+    CHECK((DecodeNormal(EncodeNormal(down)) - down).Norm() < 1e-3f);
+}
+
+TEST_CASE("Tiled lighting matches shading with every light", "[Deferred]")
+{
+    GBuffer gbuffer;
+    Canvas<float> depth;
+    FillGBuffer(gbuffer, depth);
+
+    std::mt19937 random(11);
+    std::vector<Light> lights = RandomLights(300, random);
+    // behind the camera, reaches no tile
+    Light hidden;
+    hidden.position = Vec3f{0.0f, 0.0f, 5.0f};
+    hidden.radius = 2.0f;
+    lights.push_back(hidden);
+
+    const Mat4f screen_to_view = ScreenToView();
+    const Vec3f ambient = {0.1f, 0.1f, 0.1f};
+
+    Image frame(WIDTH, HEIGHT);
+    frame.Fill(BACKGROUND);
+    TiledLighting lighting;
+    lighting.SetThreadCount(4);
+    lighting.Shade(gbuffer, depth, screen_to_view, lights, ambient, frame);
+
+    size_t mismatches = 0;
+    for (size_t y = 0; y < HEIGHT; ++y)
+    {
+        for (size_t x = 0; x < WIDTH; ++x)
+        {
+            if (gbuffer.normals.At(x, y) == 0)
+            {
+                mismatches += frame.At(x, y) == BACKGROUND ? 0 : 1;
+                continue;
+            }
+
+            const Vec4f view = screen_to_view * Vec4f{x + 0.5f, y + 0.5f, depth.At(x, y), 1.0f};
+            const Vec3f position = Project<3, float>(view) / view.w;
+            const Vec3f normal = DecodeNormal(gbuffer.normals.At(x, y));
+
+            // culled lights add exact zeros, so the sums are the same
+            Vec3f light = ambient;
+            for (const Light& l : lights)
+                light = light + LightContribution(l, position, normal);
+
+            const Color albedo = gbuffer.albedo.At(x, y);
+            const Color expected = Color((uint8_t)(std::min(255.0f, albedo.r * light.x + 0.5f)),
+                                         (uint8_t)(std::min(255.0f, albedo.g * light.y + 0.5f)),
+                                         (uint8_t)(std::min(255.0f, albedo.b * light.z + 0.5f)));
+            mismatches += frame.At(x, y) == expected ? 0 : 1;
+        }
+    }
+    CHECK(mismatches == 0);
+
+    const std::vector<uint32_t>& counts = lighting.TileLightCounts();
+    const size_t tile = TiledLighting::TILE_SIZE;
+    CHECK(counts.size() == lighting.TilesX() * ((HEIGHT + tile - 1) / tile));
+    size_t total = 0;
+    for (uint32_t count : counts)
+        total += count;
+    CHECK(total > 0);
+    // a pixel sees only a small part of the lights
+    CHECK(total < counts.size() * lights.size() / 4);
+    // the top row of tiles is not covered
+    CHECK(counts.back() == 0);
+
+    SECTION("on any number of threads")
+    {
+        Image single(WIDTH, HEIGHT);
+        single.Fill(BACKGROUND);
+        lighting.SetThreadCount(1);
+        lighting.Shade(gbuffer, depth, screen_to_view, lights, ambient, single);
+        CHECK(memcmp(single.Data(), frame.Data(), sizeof(uint32_t) * WIDTH * HEIGHT) == 0);
+    }
+}
+
+TEST_CASE("Renderer draws to the G-buffer and lights it", "[Deferred]")
+{
+    Image frame(WIDTH, HEIGHT);
+    Renderer renderer(frame);
+    renderer.Clear(BACKGROUND);
+
+    DefaultShaders::SmoothLight shader;
+    shader.color = Color(200, 100, 50);
+    renderer.SetShader(shader);
+
+    GBuffer gbuffer;
+    renderer.BeginGBuffer(gbuffer);
+    const Vec3f normal = {0.0f, 0.0f, 1.0f};
+    const Vertex a = Vertex(Vec3f{-1.0f, -0.8f, -3.0f}, normal);
+    const Vertex b = Vertex(Vec3f{1.0f, -0.8f, -3.0f}, normal);
+    const Vertex c = Vertex(Vec3f{1.0f, 0.8f, -3.0f}, normal);
+    const Vertex d = Vertex(Vec3f{-1.0f, 0.8f, -3.0f}, normal);
+    renderer.Triangle(a, b, c);
+    renderer.Triangle(a, c, d);
+    renderer.EndGBuffer();
+
+    // the target is not touched by the G-buffer pass
+    CHECK(frame.At(WIDTH / 2, HEIGHT / 2) == BACKGROUND);
+    CHECK(gbuffer.albedo.At(WIDTH / 2, HEIGHT / 2) == shader.color);
+    CHECK((DecodeNormal(gbuffer.normals.At(WIDTH / 2, HEIGHT / 2)) - normal).Norm() < 1e-3f);
+    CHECK(gbuffer.normals.At(0, 0) == 0);
+
+    Light light;
+    light.position = Vec3f{0.0f, 0.0f, -2.5f};
+    light.intensity = Vec3f{3.0f, 3.0f, 3.0f};
+    light.radius = 0.7f;
+    renderer.ShadeLights(gbuffer, {light}, Vec3f{0.2f, 0.2f, 0.2f});
+
+    CHECK(frame.At(0, 0) == BACKGROUND);
+    // straight under the light
+    const Color center = frame.At(WIDTH / 2, HEIGHT / 2);
+    CHECK(center.r > 150);
+    // beyond the radius of the light only the ambient light is left
+    const Color edge = frame.At(WIDTH / 2 - 10, HEIGHT / 2);
+    CHECK(edge == Color(40, 20, 10));
+}
@@ -0,0 +1,139 @@
+#define CATCH_CONFIG_MAIN
+#include "../common/image_scale.h"
+#include "../common/resolution_scaler.h"
+#include "../renderer/renderer.h"
+#include <catch2/catch.hpp>
+
+using namespace sr;
+
+namespace
+{
+uint8_t Channel(uint32_t pixel, int shift)
+{
+    return (pixel >> shift) & 0xff;
+}
+} // namespace
+
+TEST_CASE("Bilinear scaling", "[ImageScale]")
+{
+    Image src(7, 5);
+    for (size_t i = 0; i < src.width * src.height; ++i)
+        src.Data()[i] = 0x01020304u * (uint32_t)(i * 37 % 61);
+
+    SECTION("Same size is a copy")
+    {
+        Image dst(7, 5);
+        ScaleBilinear(src, dst);
+        CHECK(memcmp(src.Data(), dst.Data(), 7 * 5 * sizeof(uint32_t)) == 0);
+    }
+
+    SECTION("Constant stays constant")
+    {
+        src.Fill(0xff336699);
+        Image dst(19, 11);
+        ScaleBilinear(src, dst);
+        for (size_t i = 0; i < dst.width * dst.height; ++i)
+            REQUIRE(dst.Data()[i] == 0xff336699);
+    }
+
+    SECTION("Horizontal gradient")
+    {
+        Image ramp(2, 1);
+        ramp.Data()[0] = 0x00000000;
+        ramp.Data()[1] = 0x80808080;
+
+        Image dst(8, 3);
+        ScaleBilinear(ramp, dst);
+        for (size_t y = 0; y < dst.height; ++y)
+        {
+            const uint32_t* row = dst.Data() + y * dst.width;
+            CHECK(row[0] == 0);
+            CHECK(row[7] == 0x80808080);
+            for (size_t x = 1; x < dst.width; ++x)
+            {
+                for (int shift = 0; shift < 32; shift += 8)
+                    REQUIRE(Channel(row[x], shift) >= Channel(row[x - 1], shift));
+            }
+        }
+    }
+
+    SECTION("Values stay between the source pixels")
+    {
+        Image dst(16, 9);
+        ScaleBilinear(src, dst);
+        uint8_t low = 0xff, high = 0;
+        for (size_t i = 0; i < src.width * src.height; ++i)
+        {
+            low = std::min(low, Channel(src.Data()[i], 8));
+            high = std::max(high, Channel(src.Data()[i], 8));
+        }
+        for (size_t i = 0; i < dst.width * dst.height; ++i)
+        {
+            REQUIRE(Channel(dst.Data()[i], 8) >= low);
+            REQUIRE(Channel(dst.Data()[i], 8) <= high);
+        }
+    }
+}
+
+TEST_CASE("Scale follows the draw time", "[ResolutionScaler]")
+{
+    ResolutionScaler scaler(0.5f, 1.0f);
+    CHECK(scaler.Scale() == 1.0f);
+
+    // cheap frames keep the full resolution
+    for (int i = 0; i < 20; ++i)
+        scaler.Update(5.0f, 33.0f);
+    CHECK(scaler.Scale() == 1.0f);
+
+    // drawing cost proportional to the pixels settles below the budget
+    const float full_ms = 60.0f;
+    for (int i = 0; i < 200; ++i)
+        scaler.Update(full_ms * scaler.Scale() * scaler.Scale(), 33.0f);
+    const float cost = full_ms * scaler.Scale() * scaler.Scale();
+    CHECK(cost <= 33.0f);
+    CHECK(cost >= 33.0f * 0.7f);
+    CHECK(scaler.Scale() < 1.0f);
+
+    // a scene far over budget hits the limit
+    for (int i = 0; i < 50; ++i)
+        scaler.Update(500.0f, 33.0f);
+    CHECK(scaler.Scale() == 0.5f);
+
+    // and it recovers once the scene gets cheap again
+    for (int i = 0; i < 50; ++i)
+        scaler.Update(1.0f, 33.0f);
+    CHECK(scaler.Scale() == 1.0f);
+
+    CHECK(ResolutionScaler::Scaled(800, 0.5f) == 400);
+    CHECK(ResolutionScaler::Scaled(1, 0.1f) == 1);
+}
+
+TEST_CASE("Renderer follows the frame size", "[ResolutionScaler]")
+{
+    Image full(64, 64);
+    Image half(32, 32);
+    Renderer renderer(full);
+    renderer.Matrices.SetProjection(Mat4f::Identity());
+
+    DefaultShaders::SolidColor shader(Color(255, 255, 255));
+    renderer.SetShader(shader);
+    const Vertex a(Vec3f{-1.0f, -1.0f, 0.0f}), b(Vec3f{1.0f, -1.0f, 0.0f});
+    const Vertex c(Vec3f{1.0f, 1.0f, 0.0f});
+
+    renderer.Clear();
+    renderer.Triangle(a, b, c);
+    const uint64_t full_pixels = renderer.Stats().pixels_written;
+
+    renderer.SetFrame(half);
+    CHECK(renderer.Width() == 32);
+    renderer.ResetStats();
+    renderer.Clear();
+    renderer.Triangle(a, b, c);
+    const uint64_t half_pixels = renderer.Stats().pixels_written;
+
+    // the triangle covers the same part of the smaller frame
+    CHECK(half_pixels * 4 >= full_pixels * 9 / 10);
+    CHECK(half_pixels * 4 <= full_pixels * 11 / 10);
+    CHECK(half.At(31, 0) == 0xffffffff);
+    CHECK(half.At(0, 31) == 0);
+}
@@ -0,0 +1,65 @@
+#define CATCH_CONFIG_MAIN
+#include "../common/frame_scheduler.h"
+#include "../common/input.h"
+#include <catch2/catch.hpp>
+
+using namespace sr;
+using namespace std::chrono_literals;
+
+TEST_CASE("Process steps", "[FrameScheduler]")
+{
+    const auto start = FrameScheduler::Clock::now();
+    FrameScheduler scheduler(20, 0, 3);
+    scheduler.Reset(start);
+
+    CHECK(scheduler.TakeProcessSteps(start) == 1);
+    CHECK(scheduler.TakeProcessSteps(start + 10ms) == 0);
+    CHECK(scheduler.NextProcessTime() == start + 20ms);
+    CHECK(scheduler.TakeProcessSteps(start + 45ms) == 2);
+
+    // a long stall is limited to the catch-up steps and the rest is dropped
+    CHECK(scheduler.TakeProcessSteps(start + 1000ms) == 3);
+    CHECK(scheduler.NextProcessTime() == start + 1020ms);
+}
+
+TEST_CASE("Frame pacing", "[FrameScheduler]")
+{
+    const auto start = FrameScheduler::Clock::now();
+    FrameScheduler scheduler(20, 50, 3);
+    scheduler.Reset(start);
+
+    CHECK(scheduler.IsFrameDue(start));
+    scheduler.OnFrame(start);
+    CHECK_FALSE(scheduler.IsFrameDue(start + 10ms));
+    CHECK(scheduler.IsFrameDue(start + 20ms));
+
+    // a late frame does not cause a burst
+    scheduler.OnFrame(start + 100ms);
+    CHECK(scheduler.NextFrameTime() == start + 100ms);
+    scheduler.OnFrame(start + 100ms);
+    CHECK(scheduler.NextFrameTime() == start + 120ms);
+
+    FrameScheduler unlimited(20, 0, 3);
+    unlimited.Reset(start);
+    unlimited.OnFrame(start);
+    CHECK(unlimited.IsFrameDue(start));
+}
+
+TEST_CASE("Idle input", "[Input]")
+{
+    Input input;
+    CHECK(input.IsIdle());
+
+    input.OnMouseMotion(1, 2);
+    CHECK_FALSE(input.IsIdle());
+    input.OnProcessingIterationEnd();
+    CHECK(input.IsIdle());
+
+    // a held key keeps processing going without new events
+    input.OnKeyDown(KEY_W);
+    input.OnProcessingIterationEnd();
+    CHECK_FALSE(input.IsIdle());
+    input.OnKeyUp(KEY_W);
+    input.OnProcessingIterationEnd();
+    CHECK(input.IsIdle());
+}
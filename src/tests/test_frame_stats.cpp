@@ -0,0 +1,70 @@
+#define CATCH_CONFIG_MAIN
+#include "../common/font.h"
+#include "../common/frame_stats.h"
+#include <catch2/catch.hpp>
+
+using namespace sr;
+
+TEST_CASE("Percentiles", "[FrameStats]")
+{
+    FrameStats stats(100);
+    CHECK(stats.Percentiles(FrameStage::FRAME).max == 0.0f);
+
+    for (int i = 1; i <= 100; ++i)
+    {
+        FrameTiming timing;
+        timing.frame_ms = (float)(i);
+        timing.draw_ms = 1.0f;
+        stats.Add(timing);
+    }
+
+    FramePercentiles frame = stats.Percentiles(FrameStage::FRAME);
+    CHECK(frame.p50 == 50.0f);
+    CHECK(frame.p95 == 95.0f);
+    CHECK(frame.p99 == 99.0f);
+    CHECK(frame.max == 100.0f);
+    CHECK(stats.Percentiles(FrameStage::DRAW).max == 1.0f);
+
+    // the oldest frames are overwritten
+    for (int i = 0; i < 50; ++i)
+        stats.Add(FrameTiming{0.0f, 0.0f, 0.0f, 500.0f});
+    CHECK(stats.Count() == 100);
+    frame = stats.Percentiles(FrameStage::FRAME);
+    CHECK(frame.p50 == 100.0f);
+    CHECK(frame.p95 == 500.0f);
+}
+
+TEST_CASE("Text", "[Font]")
+{
+    CHECK(TextWidth("") == 0);
+    CHECK(TextWidth("AB") == 11);
+    CHECK(TextWidth("A\nBCD", 2) == 34);
+    CHECK(TextHeight("A\nB") == 16);
+
+    Image image(20, 10);
+    image.Fill(0);
+    DrawText(image, 1, 8, "i", Color(0xff, 0xff, 0xff));
+
+    // 'I' is a vertical bar in the middle column with serifs at the top and bottom
+    for (size_t y = 2; y <= 8; ++y)
+        CHECK(image.At(3, y) == 0xffffffff);
+    CHECK(image.At(2, 8) == 0xffffffff);
+    CHECK(image.At(2, 5) == 0);
+    CHECK(image.At(3, 1) == 0);
+
+    // clipped glyphs must not write outside of the image
+    DrawText(image, 17, 12, "W", Color(0xff, 0xff, 0xff), 3);
+}
+
+TEST_CASE("Overlay", "[FrameStats]")
+{
+    FrameStats stats;
+    stats.Add(FrameTiming{1.0f, 2.0f, 3.0f, 16.0f});
+
+    Image image(300, 100);
+    image.Fill(0xff808080);
+    DrawStatsOverlay(image, stats);
+
+    CHECK(image.At(299, 0) == 0xff808080);
+    CHECK(image.At(4, 95) == 0x7f404040);
+}
@@ -0,0 +1,50 @@
+#define CATCH_CONFIG_MAIN
+#include "../common/frame_writer.h"
+#include <catch2/catch.hpp>
+
+#include <cstdio>
+
+using namespace sr;
+
+TEST_CASE("Frames are written in the background", "[FrameWriter]")
+{
+    const size_t count = 8;
+    FrameWriter writer(2, 1);
+
+    Image frame(32, 16);
+    for (size_t i = 0; i < count; ++i)
+    {
+        frame.Fill(Color((uint8_t)(i * 20), 0, 0));
+        const uint32_t* pixels = frame.Data();
+
+        writer.Submit(frame, "test_frame_writer_" + std::to_string(i) + ".tga");
+
+        // the pixels went to the writer, the frame got another buffer of the same size
+        CHECK(frame.Data() != pixels);
+        CHECK(frame.width == 32);
+        CHECK(frame.height == 16);
+    }
+    REQUIRE(writer.Flush() == 0);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const std::string path = "test_frame_writer_" + std::to_string(i) + ".tga";
+        Image loaded;
+        REQUIRE(LoadTGA(path.c_str(), loaded) == 0);
+        CHECK(loaded.At(5, 5) == Color((uint8_t)(i * 20), 0, 0));
+        std::remove(path.c_str());
+    }
+}
+
+TEST_CASE("Failures are reported by flush", "[FrameWriter]")
+{
+    FrameWriter writer(1, 2);
+
+    Image frame(4, 4);
+    writer.Submit(frame, "no/such/directory/frame.tga");
+    CHECK(writer.Flush() != 0);
+
+    writer.Submit(frame, "test_frame_writer.bmp", FrameFormat::BMP);
+    CHECK(writer.Flush() == 0);
+    std::remove("test_frame_writer.bmp");
+}
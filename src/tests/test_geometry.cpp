@@ -1,5 +1,6 @@
 #define CATCH_CONFIG_MAIN
 #include "../renderer/geometry.h"
+#include "../renderer/matrix_stack.h"
 #include "../renderer/transforms.h"
 #include <catch2/catch.hpp>
 
@@ -75,3 +76,26 @@ TEST_CASE("Rotation", "[Transform]")
     CHECK((refRotateY - testRotateY).MaxAbs() < eps);
     CHECK((refRotateZ - testRotateZ).MaxAbs() < eps);
 }
+
+TEST_CASE("MatrixStack copy", "[MatrixStack]")
+{
+    const float eps = 0.001f;
+
+    MatrixStack original;
+    original.SetMode(MatrixType::VIEW);
+    original.Set(Transform::Translate(1.0f, 2.0f, 3.0f));
+
+    MatrixStack copy = original;
+    copy.Set(Transform::RotateX(1.0f));
+    original.Transform(Transform::Scale(2.0f, 2.0f, 2.0f));
+
+    // each stack keeps editing its own current matrix
+    CHECK((copy.GetModelView() - Transform::RotateX(1.0f)).MaxAbs() < eps);
+    CHECK((original.GetModelView() -
+           Transform::Translate(1.0f, 2.0f, 3.0f) * Transform::Scale(2.0f, 2.0f, 2.0f))
+              .MaxAbs() < eps);
+
+    copy = original;
+    copy.Set(Mat4f::Identity());
+    CHECK((original.GetModelView() - Mat4f::Identity()).MaxAbs() > eps);
+}
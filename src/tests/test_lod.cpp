@@ -0,0 +1,99 @@
+#define CATCH_CONFIG_MAIN
+#include "../renderer/lod.h"
+#include "../renderer/renderer.h"
+#include <catch2/catch.hpp>
+
+using namespace sr;
+
+namespace
+{
+Model GenSphere(int segments)
+{
+    auto point = [segments](int i, int j) {
+        const float theta = M_PI * i / segments;
+        const float phi = 2.0f * M_PI * (j % (2 * segments)) / (2 * segments);
+        if (i == 0)
+            return Vec3f{0.0f, 0.0f, 1.0f};
+        if (i == segments)
+            return Vec3f{0.0f, 0.0f, -1.0f};
+        return Vec3f{sinf(theta) * cosf(phi), sinf(theta) * sinf(phi), cosf(theta)};
+    };
+
+    Model model;
+    for (int i = 0; i < segments; ++i)
+        for (int j = 0; j < 2 * segments; ++j)
+        {
+            const Vec3f a = point(i, j), b = point(i + 1, j);
+            const Vec3f c = point(i + 1, j + 1), d = point(i, j + 1);
+            if (i != 0)
+                model.faces.push_back({Vertex(a), Vertex(b), Vertex(d)});
+            if (i != segments - 1)
+                model.faces.push_back({Vertex(b), Vertex(c), Vertex(d)});
+        }
+    return model;
+}
+
+Model GenGrid(int size)
+{
+    Model model;
+    for (int i = 0; i < size; ++i)
+        for (int j = 0; j < size; ++j)
+        {
+            const Vec3f a = {(float)i, (float)j, 0.0f}, b = {(float)i + 1, (float)j, 0.0f};
+            const Vec3f c = {(float)i + 1, (float)j + 1, 0.0f}, d = {(float)i, (float)j + 1, 0.0f};
+            model.faces.push_back({Vertex(a), Vertex(b), Vertex(c)});
+            model.faces.push_back({Vertex(a), Vertex(c), Vertex(d)});
+        }
+    return model;
+}
+} // namespace
+
+TEST_CASE("Planar mesh simplifies without error", "[Lod]")
+{
+    const Model grid = GenGrid(16);
+    Model simplified;
+    const float error = SimplifyModel(grid, 32, simplified);
+
+    CHECK(simplified.faces.size() <= 32);
+    CHECK(error < 1e-3f);
+    for (const Face& face : simplified.faces)
+        for (size_t i = 0; i < 3; ++i)
+            CHECK(face.v[i].coord.z == 0.0f);
+}
+
+TEST_CASE("Lod chain gets coarser", "[Lod]")
+{
+    const Model sphere = GenSphere(32);
+    LodChain lods;
+    BuildLods(sphere, lods, 5, 0.5f, 16);
+
+    REQUIRE(lods.levels.size() == 5);
+    CHECK(lods.radius == Approx(1.0f).margin(1e-3f));
+    for (size_t i = 1; i < lods.levels.size(); ++i)
+    {
+        CHECK(lods.levels[i].model.faces.size() < lods.levels[i - 1].model.faces.size());
+        CHECK(lods.levels[i].error >= lods.levels[i - 1].error);
+        CHECK(lods.levels[i].error < 0.5f);
+    }
+}
+
+TEST_CASE("Lod selection depends on projected size", "[Lod]")
+{
+    LodChain lods;
+    BuildLods(GenSphere(32), lods, 5, 0.5f, 16);
+
+    Image frame(400, 300);
+    Renderer renderer(frame);
+
+    renderer.Matrices.SetView(Transform::Translate(0.0f, 0.0f, -1.5f));
+    const float near_size = renderer.ProjectedSphereSize(lods.center, lods.radius);
+    const size_t near_level = renderer.SelectLod(lods);
+
+    renderer.Matrices.SetView(Transform::Translate(0.0f, 0.0f, -90.0f));
+    const float far_size = renderer.ProjectedSphereSize(lods.center, lods.radius);
+    const size_t far_level = renderer.SelectLod(lods);
+
+    CHECK(near_size > far_size);
+    CHECK(near_level < far_level);
+    CHECK(far_level == lods.levels.size() - 1);
+}
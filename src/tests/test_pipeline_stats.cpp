@@ -0,0 +1,108 @@
+#define CATCH_CONFIG_MAIN
+#include "../renderer/renderer.h"
+#include <catch2/catch.hpp>
+
+using namespace sr;
+
+namespace
+{
+class DiscardShader : public Shader
+{
+  public:
+    void vertex(const Vertex& v, Varyings& out) const override
+    {}
+
+    bool pixel(const Varyings& in, const ShaderContext& context, Color& result_color) const override
+    {
+        return false;
+    }
+};
+
+void DrawTriangle(Renderer& renderer, const Vec3f& p1, const Vec3f& p2, const Vec3f& p3)
+{
+    renderer.Triangle(Vertex(p1), Vertex(p2), Vertex(p3));
+}
+} // namespace
+
+TEST_CASE("Pixel counters", "[PipelineStats]")
+{
+    Image frame(100, 100);
+    Renderer renderer(frame);
+    renderer.Matrices.SetProjection(Mat4f::Identity());
+    renderer.Clear();
+
+    DefaultShaders::SolidColor shader(Color(255, 0, 0));
+    renderer.SetShader(shader);
+
+    const Vec3f a = {-0.5f, -0.5f, 0.0f}, b = {0.5f, -0.5f, 0.0f}, c = {0.0f, 0.5f, 0.0f};
+    DrawTriangle(renderer, a, b, c);
+
+    const PipelineStats& stats = renderer.Stats();
+    CHECK(stats.triangles_submitted == 1);
+    CHECK(stats.triangles_rasterized == 1);
+    CHECK(stats.TrianglesCulled() == 0);
+    CHECK(stats.triangles_clipped == 0);
+    CHECK(stats.pixels_covered > 1000);
+    CHECK(stats.pixels_depth_tested == stats.pixels_covered);
+    CHECK(stats.pixels_depth_passed == stats.pixels_covered);
+    CHECK(stats.pixels_written == stats.pixels_shaded);
+    CHECK(stats.vertices_shaded == 3);
+
+    // the same triangle again fails the depth test everywhere
+    const uint64_t covered = stats.pixels_covered;
+    DrawTriangle(renderer, a, b, c);
+    CHECK(stats.pixels_covered == 2 * covered);
+    CHECK(stats.pixels_depth_passed == covered);
+
+    renderer.ResetStats();
+    renderer.Clear();
+    DiscardShader discard;
+    renderer.SetShader(discard);
+    DrawTriangle(renderer, a, b, c);
+    CHECK(stats.pixels_shaded == covered);
+    CHECK(stats.pixels_written == 0);
+}
+
+TEST_CASE("Triangle culling", "[PipelineStats]")
+{
+    Image frame(100, 100);
+    Renderer renderer(frame);
+    renderer.Matrices.SetProjection(Mat4f::Identity());
+    renderer.Clear();
+
+    const Vec3f a = {-0.5f, -0.5f, 0.0f}, b = {0.5f, -0.5f, 0.0f}, c = {0.0f, 0.5f, 0.0f};
+    const PipelineStats& stats = renderer.Stats();
+
+    DrawTriangle(renderer, a, c, b);
+    CHECK(stats.triangles_rasterized == 1);
+
+    renderer.SetBackFaceCulling(true);
+    DrawTriangle(renderer, a, c, b);
+    CHECK(stats.triangles_culled_back_face == 1);
+    DrawTriangle(renderer, a, b, c);
+    CHECK(stats.triangles_rasterized == 2);
+
+    DrawTriangle(renderer, a, b, Vec3f{1.5f, -0.5f, 0.0f});
+    CHECK(stats.triangles_culled_zero_area == 1);
+
+    const Vec3f offset = {3.0f, 0.0f, 0.0f};
+    DrawTriangle(renderer, a + offset, b + offset, c + offset);
+    CHECK(stats.triangles_culled_off_screen == 1);
+
+    const Vec3f far = {0.0f, 0.0f, 5.0f};
+    DrawTriangle(renderer, a + far, b + far, c + far);
+    CHECK(stats.triangles_culled_depth == 1);
+
+    const Vec3f edge = {0.7f, 0.0f, 0.0f};
+    DrawTriangle(renderer, a + edge, b + edge, c + edge);
+    CHECK(stats.triangles_clipped == 1);
+    CHECK(stats.triangles_rasterized == 3);
+
+    CHECK(stats.triangles_submitted == 7);
+    CHECK(stats.TrianglesCulled() == 4);
+
+    PipelineStats total;
+    total += stats;
+    total += stats;
+    CHECK(total.triangles_submitted == 14);
+}
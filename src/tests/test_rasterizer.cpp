@@ -0,0 +1,322 @@
+#define CATCH_CONFIG_MAIN
+#include "../renderer/renderer.h"
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <random>
+#include <thread>
+
+using namespace sr;
+
+namespace
+{
+const uint8_t STEP = 10;
+
+// Grid of triangles over the whole frame with jittered inner vertices
+std::vector<Face> JitteredGrid(size_t cells, std::mt19937& random)
+{
+    std::uniform_real_distribution<float> jitter(-0.4f, 0.4f);
+    const float cell = 2.0f / cells;
+
+    std::vector<Vec3f> points((cells + 1) * (cells + 1));
+    for (size_t j = 0; j <= cells; ++j)
+    {
+        for (size_t i = 0; i <= cells; ++i)
+        {
+            const bool inner = i > 0 && i < cells && j > 0 && j < cells;
+            const float dx = inner ? jitter(random) * cell : 0.0f;
+            const float dy = inner ? jitter(random) * cell : 0.0f;
+            points[j * (cells + 1) + i] = Vec3f{-1.0f + i * cell + dx, -1.0f + j * cell + dy, 0.0f};
+        }
+    }
+
+    std::vector<Face> faces;
+    for (size_t j = 0; j < cells; ++j)
+    {
+        for (size_t i = 0; i < cells; ++i)
+        {
+            const Vec3f& a = points[j * (cells + 1) + i];
+            const Vec3f& b = points[j * (cells + 1) + i + 1];
+            const Vec3f& c = points[(j + 1) * (cells + 1) + i + 1];
+            const Vec3f& d = points[(j + 1) * (cells + 1) + i];
+            faces.push_back(Face{{Vertex(a), Vertex(b), Vertex(c)}});
+            // clockwise on purpose, the fill rule must not depend on the winding
+            faces.push_back(Face{{Vertex(a), Vertex(d), Vertex(c)}});
+        }
+    }
+    return faces;
+}
+
+// Adds STEP to the red channel of every pixel each time it is drawn
+void DrawCoverage(Image& frame, const std::vector<Face>& faces)
+{
+    Renderer renderer(frame);
+    renderer.Matrices.SetProjection(Mat4f::Identity());
+    renderer.Clear();
+
+    Color color = Color(STEP, 0, 0);
+    renderer.SetBlendMode(BlendMode::ADDITIVE);
+    for (const Face& face : faces)
+        renderer.Triangle(face.v[0].coord, face.v[1].coord, face.v[2].coord, color);
+}
+} // namespace
+
+TEST_CASE("Shared edges are covered exactly once", "[Rasterizer]")
+{
+    std::mt19937 random(42);
+    std::vector<Face> faces = JitteredGrid(13, random);
+
+    Image frame(97, 61);
+    DrawCoverage(frame, faces);
+
+    size_t wrong = 0;
+    for (size_t y = 0; y < frame.height; ++y)
+        for (size_t x = 0; x < frame.width; ++x)
+            wrong += Color(frame.At(x, y)).r == STEP ? 0 : 1;
+    CHECK(wrong == 0);
+
+    SECTION("in any order")
+    {
+        std::shuffle(faces.begin(), faces.end(), random);
+        Image shuffled(97, 61);
+        DrawCoverage(shuffled, faces);
+        CHECK(memcmp(frame.Data(), shuffled.Data(), sizeof(uint32_t) * 97 * 61) == 0);
+    }
+}
+
+TEST_CASE("Vertices are snapped to sub-pixels", "[Rasterizer]")
+{
+    const Vec3f a = {-0.53f, -0.41f, 0.0f}, b = {0.61f, -0.37f, 0.0f}, c = {0.07f, 0.58f, 0.0f};
+    // far below 1/256 of a pixel of a 100 pixel frame
+    const Vec3f shift = {1e-5f, 1e-5f, 0.0f};
+
+    Image frame1(100, 100);
+    DrawCoverage(frame1, {Face{{Vertex(a), Vertex(b), Vertex(c)}}});
+
+    Image frame2(100, 100);
+    DrawCoverage(frame2, {Face{{Vertex(a + shift), Vertex(b + shift), Vertex(c + shift)}}});
+
+    CHECK(memcmp(frame1.Data(), frame2.Data(), sizeof(uint32_t) * 100 * 100) == 0);
+}
+
+namespace
+{
+const size_t SIZE = 64;
+
+// w = z + 2, so the triangle below is seen in perspective
+Mat4f PerspectiveW()
+{
+    Mat4f mat = Mat4f::Identity();
+    mat[3][2] = 1.0f;
+    mat[3][3] = 2.0f;
+    return mat;
+}
+
+Vec2f ToScreen(const Vec3f& p)
+{
+    const float w = p.z + 2.0f;
+    return Vec2f{(p.x / w + 1.0f) * SIZE / 2, (p.y / w + 1.0f) * SIZE / 2};
+}
+
+// Checks that the interpolated position projects to a pixel center and that its derivatives lead
+// to the next pixels
+class CheckingShader : public Shader
+{
+  public:
+    // single-threaded test, the shader may keep its statistics
+    mutable size_t pixels = 0;
+    mutable float max_center_error = 0.0f;
+    mutable float max_derivative_error = 0.0f;
+
+    CheckingShader()
+    {
+        varying_count = 3;
+        needs_derivatives = true;
+    }
+
+    void vertex(const Vertex& v, Varyings& out) const override
+    {
+        out.Set(0, v.coord);
+    }
+
+    bool pixel(const Varyings& in, const ShaderContext& context,
+               Color& result_color) const override
+    {
+        ++pixels;
+        const Vec3f position = in.Get<3>(0);
+        const Vec2f screen = ToScreen(position);
+        max_center_error = std::max(max_center_error, std::fabs(Fraction(screen.x) - 0.5f));
+        max_center_error = std::max(max_center_error, std::fabs(Fraction(screen.y) - 0.5f));
+
+        const Vec2f next_x = ToScreen(position + context.dx.Get<3>(0)) - screen;
+        const Vec2f next_y = ToScreen(position + context.dy.Get<3>(0)) - screen;
+        max_derivative_error = std::max(
+            {max_derivative_error, std::fabs(next_x.x - 1.0f), std::fabs(next_x.y),
+             std::fabs(next_y.x), std::fabs(next_y.y - 1.0f)});
+
+        result_color = Color(255, 255, 255);
+        return true;
+    }
+
+  private:
+    static float Fraction(float value)
+    {
+        return value - std::floor(value);
+    }
+};
+} // namespace
+
+TEST_CASE("Varyings are perspective correct", "[Rasterizer]")
+{
+    Image frame(SIZE, SIZE);
+    Renderer renderer(frame);
+    renderer.Matrices.SetProjection(PerspectiveW());
+    renderer.Clear();
+
+    CheckingShader shader;
+    renderer.SetShader(shader);
+
+    const Vertex a = Vertex(Vec3f{-1.5f, -1.5f, 0.0f});
+    const Vertex b = Vertex(Vec3f{1.5f, -1.0f, 1.0f});
+    const Vertex c = Vertex(Vec3f{0.0f, 2.0f, 0.5f});
+    renderer.Triangle(a, b, c);
+    renderer.Triangle(a, c, b);
+    CHECK(shader.pixels > 500);
+
+    SECTION("indexed")
+    {
+        IndexedModel model;
+        model.vertices = {a, b, c};
+        model.indices = {0, 1, 2, 0, 2, 1};
+        const size_t pixels = shader.pixels;
+        renderer.Clear();
+        renderer.DrawModel(model);
+        CHECK(shader.pixels == 2 * pixels);
+        CHECK(renderer.Stats().vertices_shaded == 6 + 3);
+    }
+
+    // vertices move by up to 1/512 pixel when snapped
+    CHECK(shader.max_center_error < 0.01f);
+    // the derivatives are exact only in the limit, the perspective here is strong
+    CHECK(shader.max_derivative_error < 0.1f);
+}
+
+TEST_CASE("One shader is shared by renderers on several threads", "[Rasterizer]")
+{
+    DefaultShaders::SmoothLight shader;
+    shader.SetLightDirection(Normalize(Vec3f{0.3f, -0.5f, -1.0f}));
+
+    std::mt19937 random(7);
+    const std::vector<Face> faces = JitteredGrid(9, random);
+
+    auto draw = [&](Image& frame) {
+        Renderer renderer(frame);
+        renderer.Matrices.SetProjection(Mat4f::Identity());
+        renderer.Clear();
+        renderer.SetShader(shader);
+        for (const Face& face : faces)
+        {
+            // normals vary per vertex so every pixel reads its own varyings
+            const Vec3f n[3] = {face.v[0].coord + Vec3f{0.0f, 0.0f, -1.0f},
+                                face.v[1].coord + Vec3f{0.0f, 0.0f, -1.0f},
+                                face.v[2].coord + Vec3f{0.0f, 0.0f, -1.0f}};
+            renderer.Triangle(Vertex(face.v[0].coord, Normalize(n[0])),
+                              Vertex(face.v[1].coord, Normalize(n[1])),
+                              Vertex(face.v[2].coord, Normalize(n[2])));
+        }
+    };
+
+    Image expected(80, 60);
+    draw(expected);
+
+    std::vector<Image> frames;
+    for (size_t i = 0; i < 4; ++i)
+        frames.emplace_back(80, 60);
+    std::vector<std::thread> threads;
+    for (Image& frame : frames)
+        threads.emplace_back(draw, std::ref(frame));
+    for (std::thread& thread : threads)
+        thread.join();
+
+    for (const Image& frame : frames)
+        CHECK(memcmp(frame.Data(), expected.Data(), sizeof(uint32_t) * 80 * 60) == 0);
+}
+
+TEST_CASE("Depth-only rasterization writes the depth of the full path", "[Rasterizer]")
+{
+    std::mt19937 random(5);
+    std::uniform_real_distribution<float> coord(-20.0f, 120.0f);
+    std::uniform_real_distribution<float> depth(-20.0f, 270.0f);
+    std::uniform_real_distribution<float> w(0.5f, 3.0f);
+
+    Image scratch(100, 80);
+    Canvas<float> full(100, 80);
+    Canvas<float> depth_only(100, 80);
+    full.Fill(255.0f);
+    depth_only.Fill(255.0f);
+
+    const DefaultShaders::SolidColor shader;
+    const BlendState opaque;
+    const Varyings none = {};
+    PipelineStats full_stats, depth_stats;
+    for (size_t i = 0; i < 300; ++i)
+    {
+        Vec4f s[3];
+        for (Vec4f& v : s)
+            v = Vec4f{coord(random), coord(random), depth(random), w(random)};
+
+        RasterizeTriangle(scratch, full, 255.0f, s[0], s[1], s[2], none, none, none, shader,
+                          opaque, full_stats);
+        RasterizeDepth(depth_only, 255.0f, s[0], s[1], s[2], depth_stats);
+    }
+
+    CHECK(memcmp(full.Data(), depth_only.Data(), sizeof(float) * 100 * 80) == 0);
+    CHECK(depth_stats.triangles_rasterized == full_stats.triangles_rasterized);
+    CHECK(depth_stats.pixels_covered == full_stats.pixels_covered);
+    CHECK(depth_stats.pixels_depth_tested == full_stats.pixels_depth_tested);
+    CHECK(depth_stats.pixels_depth_passed == full_stats.pixels_depth_passed);
+}
+
+TEST_CASE("A depth prepass shades every pixel once", "[Rasterizer]")
+{
+    std::mt19937 random(8);
+    std::uniform_real_distribution<float> coord(-1.2f, 1.2f);
+    Model model;
+    for (size_t i = 0; i < 40; ++i)
+    {
+        Face face;
+        for (Vertex& v : face.v)
+            v = Vertex(Vec3f{coord(random), coord(random), coord(random) * 0.8f},
+                       Vec3f{0.0f, 0.0f, 1.0f});
+        model.faces.push_back(face);
+    }
+
+    DefaultShaders::SmoothLight shader;
+    auto setup = [&](Renderer& renderer) {
+        renderer.Matrices.SetProjection(Mat4f::Identity());
+        renderer.Clear();
+        renderer.SetShader(shader);
+    };
+
+    Image expected(64, 64);
+    Renderer direct(expected);
+    setup(direct);
+    direct.DrawModel(model);
+
+    Image frame(64, 64);
+    Renderer renderer(frame);
+    setup(renderer);
+    renderer.DrawDepth(model);
+    CHECK(renderer.Stats().pixels_shaded == 0);
+    renderer.SetDepthTest(DepthTest::LESS_EQUAL);
+    renderer.DrawModel(model);
+
+    CHECK(memcmp(frame.Data(), expected.Data(), sizeof(uint32_t) * 64 * 64) == 0);
+
+    size_t visible = 0;
+    for (size_t y = 0; y < 64; ++y)
+        for (size_t x = 0; x < 64; ++x)
+            visible += frame.At(x, y) == 0 ? 0 : 1;
+    CHECK(renderer.Stats().pixels_shaded == visible);
+    CHECK(direct.Stats().pixels_shaded > visible);
+}
@@ -0,0 +1,114 @@
+#define CATCH_CONFIG_MAIN
+#include "../renderer/renderer.h"
+#include <catch2/catch.hpp>
+
+using namespace sr;
+
+namespace
+{
+// square in the xz plane facing up
+IndexedModel Square(float half_size)
+{
+    const Vec3f up = {0.0f, 1.0f, 0.0f};
+    IndexedModel model;
+    model.vertices = {Vertex(Vec3f{-half_size, 0.0f, -half_size}, up),
+                      Vertex(Vec3f{half_size, 0.0f, -half_size}, up),
+                      Vertex(Vec3f{half_size, 0.0f, half_size}, up),
+                      Vertex(Vec3f{-half_size, 0.0f, half_size}, up)};
+    model.indices = {0, 1, 2, 0, 2, 3};
+    return model;
+}
+
+// looking down the y axis from above
+Mat4f LightView()
+{
+    return Transform::LookAt(Vec3f{0.0f, 0.0f, 0.0f}, Vec3f{0.0f, 10.0f, 0.0f},
+                             Vec3f{0.0f, 0.0f, -1.0f});
+}
+
+Mat4f LightProjection()
+{
+    return Projection::Ortho(-4.0f, 4.0f, -4.0f, 4.0f, 1.0f, 20.0f);
+}
+} // namespace
+
+TEST_CASE("Shadow maps cache the static casters", "[Shadow]")
+{
+    const IndexedModel floor = Square(4.0f);
+    const IndexedModel box = Square(1.0f);
+
+    ShadowMap map(64, 64);
+    map.SetLight(LightView(), LightProjection());
+
+    const std::vector<ShadowCaster> statics = {ShadowCaster{&floor}};
+    std::vector<ShadowCaster> dynamics = {ShadowCaster{&box, Transform::Translate(0, 2, 0)}};
+    map.Update(statics, dynamics);
+
+    CHECK(map.StaticRenders() == 1);
+    CHECK(map.Visibility(Vec3f{0.0f, 0.0f, 0.0f}) == 0.0f);
+    CHECK(map.Visibility(Vec3f{3.0f, 0.0f, 3.0f}) == 1.0f);
+    // the bias keeps the occluder from shadowing itself
+    CHECK(map.Visibility(Vec3f{0.5f, 2.0f, 0.5f}) == 1.0f);
+    // the filter softens the edge of the shadow
+    const float edge = map.Visibility(Vec3f{1.01f, 0.0f, 0.0f});
+    CHECK(edge > 0.0f);
+    CHECK(edge < 1.0f);
+
+    SECTION("moving a dynamic caster does not render the static ones")
+    {
+        const uint64_t triangles = map.Stats().triangles_submitted;
+        dynamics[0].transform = Transform::Translate(2, 2, 0);
+        map.Update(statics, dynamics);
+
+        CHECK(map.StaticRenders() == 1);
+        CHECK(map.Stats().triangles_submitted == triangles + 2);
+        CHECK(map.Visibility(Vec3f{0.0f, 0.0f, 0.0f}) == 1.0f);
+        CHECK(map.Visibility(Vec3f{2.0f, 0.0f, 0.0f}) == 0.0f);
+
+        // the same as rendering everything again
+        ShadowMap full(64, 64);
+        full.SetLight(LightView(), LightProjection());
+        full.Update({statics[0], dynamics[0]}, {});
+        CHECK(memcmp(full.Depth().Data(), map.Depth().Data(), sizeof(float) * 64 * 64) == 0);
+    }
+
+    SECTION("moving the light renders the static casters again")
+    {
+        map.SetLight(LightView(), LightProjection());
+        map.Update(statics, dynamics);
+        CHECK(map.StaticRenders() == 1);
+
+        map.SetLight(LightView() * Transform::RotateY(0.1f), LightProjection());
+        map.Update(statics, dynamics);
+        CHECK(map.StaticRenders() == 2);
+
+        map.InvalidateStatic();
+        map.Update(statics, dynamics);
+        CHECK(map.StaticRenders() == 3);
+    }
+}
+
+TEST_CASE("Shaders look up the shadow map", "[Shadow]")
+{
+    const IndexedModel floor = Square(4.0f);
+    const IndexedModel box = Square(1.0f);
+
+    ShadowMap map(64, 64);
+    map.SetLight(LightView(), LightProjection());
+    map.Update({ShadowCaster{&floor}}, {ShadowCaster{&box, Transform::Translate(0, 2, 0)}});
+
+    Image frame(32, 32);
+    Renderer renderer(frame);
+    renderer.Matrices.SetView(LightView());
+    renderer.Matrices.SetProjection(LightProjection());
+    renderer.Clear();
+
+    DefaultShaders::ShadowedLight shader;
+    shader.SetLightDirection(Vec3f{0.0f, -1.0f, 0.0f});
+    shader.SetShadowMap(&map);
+    renderer.SetShader(shader);
+    renderer.DrawModel(floor);
+
+    CHECK(frame.At(16, 16) == Color(0, 0, 0));
+    CHECK(frame.At(2, 2) == Color(255, 255, 255));
+}
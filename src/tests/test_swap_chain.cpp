@@ -0,0 +1,54 @@
+#define CATCH_CONFIG_MAIN
+#include "../common/swap_chain.h"
+#include "../renderer/renderer.h"
+#include <catch2/catch.hpp>
+
+using namespace sr;
+
+TEST_CASE("Frames rotate", "[SwapChain]")
+{
+    SwapChain chain(8, 4, 3);
+    REQUIRE(chain.Count() == 3);
+
+    Image* first = &chain.Back();
+    Image* second = &chain.Frame(1);
+    CHECK(&chain.Front() == &chain.Frame(2));
+
+    chain.Swap();
+    CHECK(&chain.Front() == first);
+    CHECK(&chain.Back() == second);
+
+    chain.Swap();
+    chain.Swap();
+    CHECK(&chain.Back() == first);
+
+    SwapChain single(8, 4, 1);
+    CHECK(&single.Front() == &single.Back());
+}
+
+TEST_CASE("Renderer follows the back frame", "[SwapChain]")
+{
+    SwapChain chain(8, 4, 2);
+    Renderer renderer(chain.Back());
+
+    renderer.Clear(Color(255, 0, 0));
+    chain.Swap();
+    renderer.SetFrame(chain.Back());
+    renderer.Clear(Color(0, 255, 0));
+
+    CHECK(chain.Front().At(1, 1) == Color(255, 0, 0));
+    CHECK(chain.Back().At(1, 1) == Color(0, 255, 0));
+
+    // a separate draw target stays selected until it is reset
+    Image target(8, 4);
+    renderer.SetDrawTarget(target);
+    chain.Swap();
+    renderer.SetFrame(chain.Back());
+    renderer.Clear(Color(0, 0, 255));
+    CHECK(target.At(1, 1) == Color(0, 0, 255));
+
+    renderer.ResetDrawTarget();
+    renderer.Clear(Color(0, 0, 0));
+    CHECK(chain.Back().At(1, 1) == Color(0, 0, 0));
+    CHECK(chain.Front().At(1, 1) == Color(0, 255, 0));
+}
@@ -0,0 +1,96 @@
+#define CATCH_CONFIG_MAIN
+#include "../renderer/texture.h"
+#include <catch2/catch.hpp>
+
+using namespace sr;
+
+namespace
+{
+Image Checkerboard(size_t width, size_t height)
+{
+    Image image(width, height);
+    for (size_t y = 0; y < height; ++y)
+        for (size_t x = 0; x < width; ++x)
+            image.At(x, y) = (x + y) % 2 ? Color(255, 255, 255) : Color(0, 0, 0);
+    return image;
+}
+} // namespace
+
+TEST_CASE("Mip chain", "[Texture]")
+{
+    const Texture texture(Checkerboard(16, 4));
+
+    REQUIRE(texture.Levels() == 5);
+    CHECK(texture.Level(1).width == 8);
+    CHECK(texture.Level(1).height == 2);
+    CHECK(texture.Level(2).height == 1);
+    CHECK(texture.Level(4).width == 1);
+
+    const Color average = texture.Level(4).At(0, 0);
+    CHECK(std::abs(average.r - 128) <= 1);
+}
+
+TEST_CASE("Level of detail", "[Texture]")
+{
+    const Texture texture(Checkerboard(64, 64));
+
+    CHECK(texture.LevelOfDetail(Vec2f{1.0f / 64, 0.0f}, Vec2f{0.0f, 1.0f / 64}) == 0.0f);
+    CHECK(texture.LevelOfDetail(Vec2f{4.0f / 64, 0.0f}, Vec2f{0.0f, 1.0f / 64}) ==
+          Approx(2.0f));
+    CHECK(texture.LevelOfDetail(Vec2f{1.0f, 0.0f}, Vec2f{0.0f, 1.0f}) == Approx(6.0f));
+}
+
+TEST_CASE("Sampling filters", "[Texture]")
+{
+    const Texture texture(Checkerboard(64, 64));
+    const Vec2f uv = {0.5f, 0.5f};
+    const Vec2f small = {1.0f / 64, 0.0f};
+    const Vec2f large = {1.0f, 0.0f};
+
+    const Sampler nearest_sampler(TextureFilter::NEAREST, TextureWrap::CLAMP);
+    const Color nearest = nearest_sampler.Sample(texture, uv, small, small);
+    CHECK((nearest.r == 0 || nearest.r == 255));
+
+    const Sampler bilinear_sampler(TextureFilter::BILINEAR, TextureWrap::CLAMP);
+    const Color bilinear = bilinear_sampler.Sample(texture, Vec2f{0.5f + 0.5f / 64, 0.5f});
+    CHECK(std::abs(bilinear.r - 128) <= 1);
+
+    const Color minified = Sampler().Sample(texture, uv, large, large);
+    CHECK(std::abs(minified.r - 128) <= 1);
+}
+
+TEST_CASE("Tiled storage", "[Texture]")
+{
+    Image image(6, 5);
+    for (size_t y = 0; y < image.height; ++y)
+        for (size_t x = 0; x < image.width; ++x)
+            image.At(x, y) = (uint32_t)(y * 100 + x);
+
+    const TiledImage tiled(image);
+    CHECK_FALSE(tiled.IsPowerOfTwo());
+    for (size_t y = 0; y < image.height; ++y)
+        for (size_t x = 0; x < image.width; ++x)
+            CHECK(tiled.At(x, y) == image.At(x, y));
+
+    uint32_t quad[4];
+    tiled.Quad(3, 3, 4, 4, quad);
+    CHECK(quad[0] == 303);
+    CHECK(quad[1] == 304);
+    CHECK(quad[2] == 403);
+    CHECK(quad[3] == 404);
+}
+
+TEST_CASE("Wrap addressing", "[Texture]")
+{
+    Image image(4, 4);
+    for (size_t y = 0; y < image.height; ++y)
+        for (size_t x = 0; x < image.width; ++x)
+            image.At(x, y) = Color((uint8_t)(x * 10), 0, 0);
+    const Texture texture(image);
+
+    const Sampler clamp(TextureFilter::NEAREST, TextureWrap::CLAMP);
+    const Sampler repeat(TextureFilter::NEAREST, TextureWrap::REPEAT);
+    CHECK(clamp.Sample(texture, Vec2f{1.3f, 0.5f}).r == 30);
+    CHECK(repeat.Sample(texture, Vec2f{1.3f, 0.5f}).r == 10);
+    CHECK(repeat.Sample(texture, Vec2f{-0.2f, 0.5f}).r == 30);
+}
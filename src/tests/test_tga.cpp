@@ -0,0 +1,149 @@
+#define CATCH_CONFIG_MAIN
+#include "../common/byte_sink.h"
+#include "../common/canvas.h"
+#include "../external/tgaimage/tgaimage.h"
+#include <catch2/catch.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+using namespace sr;
+
+namespace
+{
+TGA::TGAImage RandomTga(int width, int height, int bytespp)
+{
+    std::mt19937 random(width * 31 + height);
+    TGA::TGAImage tga(width, height, bytespp);
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x)
+        {
+            // short runs of equal pixels give RLE both kinds of packets
+            const uint32_t value = (x / 3) % 2 ? 0x80402010u : random();
+            tga.set(x, y, TGA::TGAColor(value & 0xff, (value >> 8) & 0xff, (value >> 16) & 0xff,
+                                        value >> 24));
+        }
+    return tga;
+}
+
+void CheckSame(TGA::TGAImage& tga, const Image& image)
+{
+    REQUIRE(image.width == (size_t)(tga.get_width()));
+    REQUIRE(image.height == (size_t)(tga.get_height()));
+
+    const bool has_alpha = tga.get_bytespp() == 4;
+    for (size_t y = 0; y < image.height; ++y)
+        for (size_t x = 0; x < image.width; ++x)
+        {
+            // TGAImage keeps rows from top to bottom, the same as Image memory
+            const TGA::TGAColor expected = tga.get(x, y);
+            const Color actual = image.Data()[y * image.width + x];
+            CHECK(actual.b == expected.bgra[0]);
+            CHECK(actual.g == expected.bgra[1]);
+            CHECK(actual.r == expected.bgra[2]);
+            CHECK(actual.a == (has_alpha ? expected.bgra[3] : 0xff));
+        }
+}
+} // namespace
+
+TEST_CASE("Load uncompressed and RLE", "[TGA]")
+{
+    const char* path = "test_tga.tga";
+
+    for (int bytespp : {3, 4})
+    {
+        for (bool rle : {false, true})
+        {
+            TGA::TGAImage tga = RandomTga(37, 11, bytespp);
+            REQUIRE(tga.write_tga_file(path, rle));
+
+            Image image;
+            REQUIRE(LoadTGA(path, image) == 0);
+            CheckSame(tga, image);
+        }
+    }
+
+    std::remove(path);
+}
+
+TEST_CASE("Load bottom-up file", "[TGA]")
+{
+    const char* path = "test_tga_bottom_up.tga";
+
+    // 2x2 uncompressed 24 bpp with the default bottom-left origin
+    const uint8_t file[] = {0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 2, 0, 24, 0,
+                            1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+    std::ofstream(path, std::ios::binary).write((const char*)(file), sizeof(file));
+
+    Image image;
+    REQUIRE(LoadTGA(path, image) == 0);
+    CHECK(image.At(0, 0) == Color(3, 2, 1));
+    CHECK(image.At(1, 0) == Color(6, 5, 4));
+    CHECK(image.At(0, 1) == Color(9, 8, 7));
+    CHECK(image.At(1, 1) == Color(12, 11, 10));
+
+    std::remove(path);
+}
+
+TEST_CASE("Reject truncated file", "[TGA]")
+{
+    const char* path = "test_tga_truncated.tga";
+
+    const uint8_t file[] = {0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 2, 0, 24, 0, 1, 2, 3};
+    std::ofstream(path, std::ios::binary).write((const char*)(file), sizeof(file));
+
+    Image image;
+    CHECK(LoadTGA(path, image) != 0);
+
+    std::remove(path);
+}
+
+TEST_CASE("Write and load back", "[TGA]")
+{
+    const char* path = "test_tga_written.tga";
+
+    Image image(150, 7);
+    for (size_t y = 0; y < image.height; ++y)
+        for (size_t x = 0; x < image.width; ++x)
+            image.At(x, y) = x < 140 ? Color((uint8_t)(y * 30), 7, 9) : Color((uint8_t)(x), 0, 0);
+    image.At(3, 2) = 0x40102030;
+
+    for (bool rle : {false, true})
+    {
+        for (bool alpha : {false, true})
+        {
+            REQUIRE(DumpTga(path, image, TgaOptions{rle, alpha}) == 0);
+
+            Image loaded;
+            REQUIRE(LoadTGA(path, loaded) == 0);
+            REQUIRE(loaded.width == image.width);
+            REQUIRE(loaded.height == image.height);
+            for (size_t i = 0; i < image.width * image.height; ++i)
+            {
+                const Color expected = alpha ? image.Data()[i] : image.Data()[i] | 0xff000000;
+                CHECK(loaded.Data()[i] == expected);
+            }
+        }
+    }
+
+    std::remove(path);
+}
+
+TEST_CASE("Write into memory", "[TGA]")
+{
+    Image image(64, 64);
+    image.Fill(Color(1, 2, 3));
+
+    const TgaOptions options = {true, false};
+    std::vector<uint8_t> buffer(TgaMaxSize(image.width, image.height, options));
+    MemorySink sink(buffer.data(), buffer.size());
+    REQUIRE(WriteTga(sink, image, options) == 0);
+
+    // one run packet per row
+    CHECK(sink.Size() == 18 + 64 * 4 + 26);
+    CHECK(buffer[2] == 10);
+
+    MemorySink small(buffer.data(), 100);
+    CHECK(WriteTga(small, image, options) != 0);
+}
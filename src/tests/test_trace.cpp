@@ -0,0 +1,74 @@
+#define CATCH_CONFIG_MAIN
+#include "../common/byte_sink.h"
+#include "../common/trace.h"
+#include <catch2/catch.hpp>
+
+#include <thread>
+
+using namespace sr;
+
+namespace
+{
+std::string ExportJson()
+{
+    std::vector<char> buffer(16 << 20);
+    MemorySink sink(buffer.data(), buffer.size());
+    REQUIRE(Tracer::Instance().WriteJson(sink) == 0);
+    return std::string(buffer.data(), sink.Size());
+}
+
+size_t CountOf(const std::string& string, const std::string& pattern)
+{
+    size_t count = 0;
+    for (size_t pos = string.find(pattern); pos != std::string::npos;
+         pos = string.find(pattern, pos + 1))
+        ++count;
+    return count;
+}
+} // namespace
+
+TEST_CASE("Scopes of threads", "[Trace]")
+{
+    Tracer::Instance().Clear();
+
+    {
+        TraceScope outer("outer");
+        TraceScope inner("inner");
+    }
+
+    std::thread worker([]() {
+        Tracer::Instance().SetThreadName("worker");
+        TraceScope scope("work");
+    });
+    worker.join();
+
+    const std::string json = ExportJson();
+    CHECK(json.rfind("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 0) == 0);
+    CHECK(json.substr(json.size() - 4) == "\n]}\n");
+    CHECK(CountOf(json, "\"ph\":\"X\"") == 3);
+    CHECK(CountOf(json, "\"name\":\"outer\"") == 1);
+    CHECK(CountOf(json, "\"name\":\"inner\"") == 1);
+    CHECK(CountOf(json, "\"args\":{\"name\":\"worker\"}") == 1);
+
+    // events of the worker are on another thread id
+    const size_t main_tid = json.find("\"tid\":", json.find("\"outer\""));
+    const size_t worker_tid = json.find("\"tid\":", json.find("\"work\""));
+    CHECK(json.substr(main_tid, 8) != json.substr(worker_tid, 8));
+}
+
+TEST_CASE("Ring buffer keeps the newest events", "[Trace]")
+{
+    Tracer::Instance().Clear();
+
+    const size_t count = Tracer::BUFFER_CAPACITY + 10;
+    for (size_t i = 0; i < count; ++i)
+        Tracer::Instance().Record(i < 10 ? "old" : "new", i * 1000, i * 1000 + 500);
+
+    const std::string json = ExportJson();
+    CHECK(CountOf(json, "\"name\":\"old\"") == 0);
+    CHECK(CountOf(json, "\"name\":\"new\"") == Tracer::BUFFER_CAPACITY);
+    CHECK(CountOf(json, "\"ts\":10.000,\"dur\":0.500") == 1);
+
+    Tracer::Instance().Clear();
+    CHECK(CountOf(ExportJson(), "\"ph\":\"X\"") == 0);
+}
@@ -0,0 +1,107 @@
+#define CATCH_CONFIG_MAIN
+#include "../common/video_stream.h"
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace sr;
+
+namespace
+{
+// plain per-pixel BT.601 reference
+int Luma(Color c)
+{
+    return ((66 * c.r + 129 * c.g + 25 * c.b + 128) >> 8) + 16;
+}
+} // namespace
+
+TEST_CASE("YUV 4:2:0 conversion", "[VideoStream]")
+{
+    // odd sizes exercise both the vector and the edge paths
+    for (size_t width : {16, 21})
+    {
+        for (size_t height : {6, 7})
+        {
+            Image image(width, height);
+            for (size_t i = 0; i < width * height; ++i)
+                image.Data()[i] = Color((uint8_t)(i * 7), (uint8_t)(i * 13), (uint8_t)(i * 29));
+
+            const size_t chroma_width = (width + 1) / 2;
+            const size_t chroma_height = (height + 1) / 2;
+            std::vector<uint8_t> y(width * height), u(chroma_width * chroma_height),
+                v(chroma_width * chroma_height);
+            ConvertToYUV420(image.Data(), width, height, y.data(), u.data(), v.data());
+
+            for (size_t i = 0; i < width * height; ++i)
+                CHECK((int)(y[i]) == Luma(image.Data()[i]));
+
+            for (size_t cy = 0; cy < chroma_height; ++cy)
+                for (size_t cx = 0; cx < chroma_width; ++cx)
+                {
+                    int r = 2, g = 2, b = 2;
+                    for (size_t row : {2 * cy, std::min(2 * cy + 1, height - 1)})
+                        for (size_t column : {2 * cx, std::min(2 * cx + 1, width - 1)})
+                        {
+                            const Color c = image.Data()[row * width + column];
+                            r += c.r;
+                            g += c.g;
+                            b += c.b;
+                        }
+                    r >>= 2;
+                    g >>= 2;
+                    b >>= 2;
+                    CHECK((int)(u[cy * chroma_width + cx]) ==
+                          ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+                    CHECK((int)(v[cy * chroma_width + cx]) ==
+                          ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+                }
+
+            // a 2x2 block of one color keeps the chroma of that color
+            Image flat(width, height);
+            flat.Fill(Color(255, 0, 0));
+            ConvertToYUV420(flat.Data(), width, height, y.data(), u.data(), v.data());
+            CHECK((int)(y[0]) == 82);
+            CHECK((int)(u.back()) == 90);
+            CHECK((int)(v.back()) == 240);
+            CHECK((int)(u[0]) == 90);
+        }
+    }
+}
+
+TEST_CASE("Y4M stream", "[VideoStream]")
+{
+    std::vector<uint8_t> buffer(1024);
+    MemorySink sink(buffer.data(), buffer.size());
+    VideoStream stream(sink, VideoFormat::Y4M, 25);
+
+    Image frame(4, 2);
+    frame.Fill(Color(0, 0, 0));
+    REQUIRE(stream.WriteFrame(frame) == 0);
+    REQUIRE(stream.WriteFrame(frame) == 0);
+
+    const std::string header = "YUV4MPEG2 W4 H2 F25:1 Ip A1:1 C420jpeg\nFRAME\n";
+    REQUIRE(sink.Size() == header.size() + 2 * (8 + 2 + 2) + 6);
+    CHECK(std::string(buffer.begin(), buffer.begin() + header.size()) == header);
+    CHECK(buffer[header.size()] == 16);
+
+    Image other(2, 2);
+    CHECK(stream.WriteFrame(other) != 0);
+}
+
+TEST_CASE("PPM stream", "[VideoStream]")
+{
+    std::vector<uint8_t> buffer(1024);
+    MemorySink sink(buffer.data(), buffer.size());
+    VideoStream stream(sink, VideoFormat::PPM);
+
+    Image frame(2, 1);
+    frame.At(0, 0) = Color(1, 2, 3);
+    frame.At(1, 0) = Color(4, 5, 6);
+    REQUIRE(stream.WriteFrame(frame) == 0);
+
+    const std::string expected = std::string("P6\n2 1\n255\n") + "\x01\x02\x03\x04\x05\x06";
+    REQUIRE(sink.Size() == expected.size());
+    CHECK(std::string(buffer.begin(), buffer.begin() + sink.Size()) == expected);
+}
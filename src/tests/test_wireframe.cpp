@@ -0,0 +1,135 @@
+#define CATCH_CONFIG_MAIN
+#include "../renderer/renderer.h"
+#include "../renderer/wireframe.h"
+#include <catch2/catch.hpp>
+
+using namespace sr;
+
+namespace
+{
+const Color WIRE = Color(0, 255, 0);
+
+void AddQuad(Model& model, Vec3f a, Vec3f b, Vec3f c, Vec3f d)
+{
+    model.faces.push_back(Face{{Vertex(a), Vertex(b), Vertex(c)}});
+    model.faces.push_back(Face{{Vertex(a), Vertex(c), Vertex(d)}});
+}
+
+Model Cube()
+{
+    const Vec3f p[8] = {{-1, -1, -1}, {1, -1, -1}, {1, 1, -1}, {-1, 1, -1},
+                        {-1, -1, 1},  {1, -1, 1},  {1, 1, 1},  {-1, 1, 1}};
+    Model model;
+    AddQuad(model, p[0], p[3], p[2], p[1]);
+    AddQuad(model, p[4], p[5], p[6], p[7]);
+    AddQuad(model, p[0], p[1], p[5], p[4]);
+    AddQuad(model, p[2], p[3], p[7], p[6]);
+    AddQuad(model, p[1], p[2], p[6], p[5]);
+    AddQuad(model, p[0], p[4], p[7], p[3]);
+    return model;
+}
+
+EdgeMesh Segment(Vec3f a, Vec3f b)
+{
+    EdgeMesh mesh;
+    mesh.positions = {a, b};
+    mesh.edges = {0, 1};
+    return mesh;
+}
+
+size_t CountColor(const Image& frame, Color color)
+{
+    size_t count = 0;
+    for (size_t y = 0; y < frame.height; ++y)
+    {
+        for (size_t x = 0; x < frame.width; ++x)
+            count += frame.At(x, y) == color ? 1 : 0;
+    }
+    return count;
+}
+} // namespace
+
+TEST_CASE("Shared edges are stored once", "[Wireframe]")
+{
+    EdgeMesh mesh;
+    BuildEdgeMesh(Cube(), mesh);
+
+    CHECK(mesh.positions.size() == 8);
+    // 12 cube edges and a diagonal of each face
+    CHECK(mesh.EdgeCount() == 18);
+}
+
+TEST_CASE("Edges are drawn between projected vertices", "[Wireframe]")
+{
+    Image frame(100, 100);
+    Renderer renderer(frame);
+    renderer.Matrices.SetProjection(Mat4f::Identity());
+    renderer.Clear();
+
+    renderer.DrawWireframe(Segment({-0.5f, -0.5f, 0.0f}, {0.5f, 0.5f, 0.0f}), WIRE);
+
+    CHECK(frame.At(25, 25) == WIRE);
+    CHECK(frame.At(50, 50) == WIRE);
+    CHECK(frame.At(75, 75) == WIRE);
+    CHECK(CountColor(frame, WIRE) == 51);
+}
+
+TEST_CASE("Edges are clipped to the frame", "[Wireframe]")
+{
+    Image frame(100, 100);
+    Renderer renderer(frame);
+    renderer.Matrices.SetProjection(Mat4f::Identity());
+    renderer.Clear();
+
+    SECTION("outside")
+    {
+        renderer.DrawWireframe(Segment({-3.0f, -2.0f, 0.0f}, {-2.0f, 3.0f, 0.0f}), WIRE);
+        CHECK(CountColor(frame, WIRE) == 0);
+    }
+
+    SECTION("crossing")
+    {
+        renderer.DrawWireframe(Segment({-3.0f, 0.0f, 0.0f}, {3.0f, 0.0f, 0.0f}), WIRE);
+        CHECK(CountColor(frame, WIRE) == 100);
+        CHECK(frame.At(0, 50) == WIRE);
+        CHECK(frame.At(99, 50) == WIRE);
+    }
+
+    SECTION("diagonal through corners")
+    {
+        renderer.DrawWireframe(Segment({-2.0f, 2.0f, 0.0f}, {2.0f, -2.0f, 0.0f}), WIRE);
+        CHECK(CountColor(frame, WIRE) > 0);
+        CHECK(frame.At(50, 50) == WIRE);
+    }
+}
+
+TEST_CASE("Depth tested edges are hidden behind surfaces", "[Wireframe]")
+{
+    Image frame(100, 100);
+    Renderer renderer(frame);
+    renderer.Matrices.SetProjection(Mat4f::Identity());
+    renderer.Clear();
+
+    // covers the left half of the frame in front of the edge
+    const Color SOLID = Color(255, 0, 0);
+    renderer.Triangle(Vec3f{-1.0f, -1.0f, -0.5f}, Vec3f{0.0f, -1.0f, -0.5f},
+                      Vec3f{0.0f, 1.0f, -0.5f}, SOLID);
+    renderer.Triangle(Vec3f{-1.0f, -1.0f, -0.5f}, Vec3f{0.0f, 1.0f, -0.5f},
+                      Vec3f{-1.0f, 1.0f, -0.5f}, SOLID);
+
+    const EdgeMesh edge = Segment({-0.8f, 0.0f, 0.0f}, {0.8f, 0.0f, 0.0f});
+
+    SECTION("hidden")
+    {
+        renderer.DrawWireframe(edge, WIRE, true);
+        CHECK(frame.At(20, 50) == SOLID);
+        CHECK(frame.At(80, 50) == WIRE);
+    }
+
+    SECTION("without depth test")
+    {
+        renderer.DrawWireframe(edge, WIRE);
+        CHECK(frame.At(20, 50) == WIRE);
+        CHECK(frame.At(80, 50) == WIRE);
+    }
+}